@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include <SPI.h>
+#include <RadioLib_wrapper.h>
+#include <Radio_tdma.h>
+
+// The beacons are timestamped by the receive ring, enable it in platformio.ini:
+//   build_flags = -D RADIOLIB_WRAPPER_RX_RING_LENGTH=4
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH == 0
+#error "Set RADIOLIB_WRAPPER_RX_RING_LENGTH in the build flags, TDMA needs the receive ring"
+#endif
+
+// Pins for the SPI bus, that the radio module uses
+const int SPI_RX = 4; // MISO
+const int SPI_TX = 7; // MOSI
+const int SPI_SCK = 6;
+
+// Node number of this board. Node 0 (ground station) sends the beacons
+// Flash every board with a different number
+const uint8_t NODE_ID = 0;
+
+// Data slots of every superframe and the node that owns them: ground, rocket, payload, rocket
+const uint8_t SLOT_OWNERS[] = {0, 1, 2, 1};
+
+// Longest frame that is sent in a data slot
+const uint8_t MAX_FRAME_LENGTH = 64;
+
+// Radio module config
+RadioLib_Wrapper<SX1268>::Radio_Config radio_config{
+    .frequency = 434.5,
+    .cs = 2,
+    .dio0 = 3,
+    .dio1 = 5,
+    .family = RadioLib_Wrapper<SX1268>::Radio_Config::Chip_Family::Sx126x,
+    .rf_switching = RadioLib_Wrapper<SX1268>::Radio_Config::Rf_Switching::Dio2,
+    .rx_enable = -1,
+    .tx_enable = -1,
+    .reset = 8,
+    .sync_word = 0xF4,
+    .tx_power = 14,
+    .spreading = 7,
+    .coding_rate = 5,
+    .signal_bw = 125,
+    .frequency_correction = false,
+    .spi_bus = &SPI,
+};
+
+RadioLib_Wrapper<SX1268> radio;
+Radio_Tdma *tdma;
+
+int message_index = 1;
+
+void setup()
+{
+    Serial.begin(115200);
+
+    // Configure and begin SPI bus
+    SPI.setRX(SPI_RX);
+    SPI.setTX(SPI_TX);
+    SPI.setSCK(SPI_SCK);
+    SPI.begin();
+
+    if (!radio.begin(radio_config))
+    {
+        while (true)
+        {
+            Serial.println("Configuring LoRa failed");
+            delay(5000);
+        }
+    }
+    // Beacons must be timestamped in the interrupt
+    radio.start_receive_buffering();
+
+    // Slot and guard times follow the time on air with the configured modulation
+    Radio_Tdma::Config tdma_config{
+        .node_id = NODE_ID,
+        .slot_owners = SLOT_OWNERS,
+        .slot_count = sizeof(SLOT_OWNERS),
+        .beacon_time_on_air = radio.get_time_on_air(RADIO_TDMA_BEACON_LENGTH),
+        .max_time_on_air = radio.get_time_on_air(MAX_FRAME_LENGTH),
+        .clock_tolerance = 50, // Typical crystal
+        .timing_margin = 3,
+        .max_missed_beacons = 2,
+    };
+    tdma = new Radio_Tdma(tdma_config);
+    Serial.println("Superframe length: " + String(tdma->get_superframe_length()) + " ms");
+}
+
+void loop()
+{
+    radio.poll();
+
+    // Beacons keep the superframes aligned, everything else is data
+    uint8_t frame[256];
+    uint16_t length;
+    RadioLib_Wrapper<SX1268>::Rx_Metadata metadata;
+    while (radio.read_received_bytes(frame, sizeof(frame), length, metadata))
+    {
+        if (!tdma->receive(frame, length, metadata.timestamp))
+        {
+            frame[length < sizeof(frame) ? length : sizeof(frame) - 1] = '\0';
+            Serial.println("LoRa received: " + String((char *)frame) + " | RSSI: " + metadata.rssi + " | SNR: " + metadata.snr);
+        }
+    }
+
+    // Ground station sends the beacon at the start of every superframe
+    length = tdma->build_beacon(frame, sizeof(frame));
+    if (length != 0 && radio.transmit_bytes(frame, length))
+    {
+        tdma->mark_beacon_sent();
+    }
+
+    // Send a message in every own slot. Nothing is sent until the first beacon is received
+    String tx_message = "Node " + String(NODE_ID) + " message " + String(message_index);
+    if (tdma->transmit_bytes(radio, (uint8_t *)tx_message.c_str(), tx_message.length()))
+    {
+        message_index++;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+
+/**
+ * @brief Batches several small CCSDS packets into one radio frame, so the LoRa preamble and header
+ * airtime is paid once per frame instead of once per packet. The packets are stored back to back
+ * unchanged, so the receiver can split them with split_ccsds_frame() or a Ccsds_Deframer.
+ *
+ * Example:
+ *   if (!aggregator.add(packet, length))
+ *   {
+ *     // Frame is full, send it and start a new one
+ *     if (radio.transmit_bytes(aggregator.get_frame(), aggregator.get_frame_length())) aggregator.clear();
+ *     aggregator.add(packet, length);
+ *   }
+ *   if (aggregator.is_flush_due() && radio.transmit_bytes(aggregator.get_frame(), aggregator.get_frame_length()))
+ *   {
+ *     aggregator.clear();
+ *   }
+ */
+class Ccsds_Aggregator
+{
+public:
+  struct Config
+  {
+    uint16_t max_frame_length;      // Radio frame size limit, at most CCSDS_MAX_FRAME_LENGTH (0 - CCSDS_MAX_FRAME_LENGTH)
+    uint8_t max_packets;            // Flush after this many packets (0 - only limited by frame length)
+    unsigned long flush_deadline;   // Maximum time in ms the first packet in a frame can wait before the frame is sent
+  };
+
+private:
+  uint8_t _frame[CCSDS_MAX_FRAME_LENGTH];
+  uint16_t _frame_length;
+  uint8_t _packet_count;
+  unsigned long _first_packet_time;
+  Config _config;
+
+public:
+  /**
+   * @brief Create a new aggregator
+   * @param config Aggregator config
+   */
+  Ccsds_Aggregator(const Config &config);
+
+  /**
+   * @brief Add a full CCSDS packet to the current frame
+   * @param packet Pointer to CCSDS packet byte array
+   * @param length Length of CCSDS packet
+   * @param now Current time in ms, used for the flush deadline
+   * @return True if added. False if it doesn't fit, in which case the frame must be sent and cleared first
+   */
+  bool add(const uint8_t *packet, uint16_t length, unsigned long now = millis());
+
+  /**
+   * @brief Check if the current frame should be sent now
+   * @param now Current time in ms
+   * @return True if the packet limit is reached or the first packet has waited for the flush deadline
+   */
+  bool is_flush_due(unsigned long now = millis()) const;
+
+  /**
+   * @brief Remove all packets from the frame. Call after the frame was transmitted
+   */
+  void clear();
+
+  uint8_t *get_frame() { return _frame; }
+  uint16_t get_frame_length() const { return _frame_length; }
+  uint8_t get_packet_count() const { return _packet_count; }
+  bool is_empty() const { return _packet_count == 0; }
+
+  /**
+   * @brief Get the space left in the frame
+   * @return Number of bytes the next packet can have
+   */
+  uint16_t get_free_length() const { return _config.max_frame_length - _frame_length; }
+};
+
+/**
+ * @brief Split a received frame containing one or more back to back CCSDS packets
+ * @param frame Pointer to the received frame
+ * @param frame_length Length of the received frame
+ * @param packet_function Function to call with every valid packet. The view points into the frame
+ * @param layout Secondary header layout of the packets
+ * @return Number of valid packets found
+ * @note Corrupted packets are skipped and the following packets are still found
+ */
+uint8_t split_ccsds_frame(const uint8_t *frame, uint16_t frame_length, void (*packet_function)(const Ccsds_Packet_View &), Ccsds_Packet_View::Layout layout = Ccsds_Packet_View::Layout::Telemetry);
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,93 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+
+/*
+  Optional delta compression of CCSDS telemetry data.
+
+  Every compressed packet data field starts with a one byte compression header
+  (the secondary header has no spare bits):
+    bit 7    - 0 keyframe, 1 delta packet
+    bits 0-6 - keyframe id (counts keyframes, wraps at 128)
+
+  A keyframe carries the absolute values, encoded as usual with the data format.
+  A delta packet carries one zigzag varint per value: the difference to the value
+  in the keyframe with the same id. Deltas are always against the keyframe and not
+  the previous packet, so a lost delta packet doesn't affect the following ones.
+  Delta packets that reference a keyframe the receiver doesn't have are rejected.
+  Float deltas are taken of the bit pattern, so the compression is lossless.
+*/
+
+const uint8_t CCSDS_COMPRESSION_DELTA_FLAG = 0x80;
+const uint8_t CCSDS_COMPRESSION_KEYFRAME_ID_MASK = 0x7F;
+
+/**
+ * @brief Encodes telemetry values as keyframes or deltas against the last keyframe
+ */
+class Ccsds_Delta_Encoder
+{
+private:
+  Ccsds_Decode_Plan _plan;
+  Converter _keyframe_values[CCSDS_DECODE_PLAN_MAX_FIELDS];
+  uint8_t _keyframe_id;
+  uint16_t _keyframe_interval;
+  uint16_t _packets_since_keyframe;
+  bool _has_keyframe;
+
+public:
+  /**
+   * @brief Create a new encoder
+   * @param plan Data format of the values
+   * @param keyframe_interval Send a keyframe every this many packets (1 disables compression)
+   */
+  Ccsds_Delta_Encoder(const Ccsds_Decode_Plan &plan, uint16_t keyframe_interval = 10);
+
+  /**
+   * @brief Encode values into compressed packet data
+   * @param ccsds_data Pointer to data byte array
+   * @param data_length Size of the data byte array
+   * @param data_values Values in the order of the data format
+   * @return Number of bytes written or 0 if the data byte array is too small
+   */
+  uint16_t encode(uint8_t *ccsds_data, uint16_t data_length, const Converter *data_values);
+
+  /**
+   * @brief Encode values directly at the end of a packet being built
+   * @param builder Packet builder after begin() was called
+   * @param data_values Values in the order of the data format
+   * @return True if the values fit in the packet
+   */
+  bool append(Ccsds_Packet_Builder &builder, const Converter *data_values);
+
+  /**
+   * @brief Make the next packet a keyframe, for example after the receiver reported losing one
+   */
+  void force_keyframe() { _has_keyframe = false; }
+};
+
+/**
+ * @brief Keeps the last received keyframe to decode delta packets
+ * @note Use one decoder per APID
+ */
+struct Ccsds_Delta_Decoder
+{
+  Ccsds_Decode_Plan plan;
+  Converter keyframe_values[CCSDS_DECODE_PLAN_MAX_FIELDS];
+  uint8_t keyframe_id = 0;
+  bool has_keyframe = false;
+
+  Ccsds_Delta_Decoder(const Ccsds_Decode_Plan &decode_plan) : plan(decode_plan) {}
+};
+
+/**
+ * @brief Read compressed CCSDS packet data, updating the decoder when a keyframe is received
+ * @param ccsds_data Pointer to data byte array
+ * @param data_length Length of data in packet
+ * @param data_values Pointer to data values array with at least decoder.plan.field_count elements
+ * @param decoder Decoder state for this APID
+ * @return True if the values were decoded. False if the data is malformed or the referenced keyframe is missing
+ */
+bool extract_ccsds_data_values(const uint8_t *ccsds_data, uint16_t data_length, Converter *data_values, Ccsds_Delta_Decoder &decoder);
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,75 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+
+/**
+ * @brief Extracts CCSDS packets from a continuous byte stream (UART tap, concatenated SD log, radio capture).
+ * Chunks of any size can be pushed in. Packets are located using the primary header length field and
+ * only emitted if their checksum is correct. After corrupted or unrelated bytes the deframer resynchronizes
+ * by dropping one byte at a time until a valid packet is found.
+ * @note Only one packet worth of data (CCSDS_MAX_PACKET_LENGTH bytes) is buffered internally
+ */
+class Ccsds_Deframer
+{
+public:
+  struct Statistics
+  {
+    uint32_t packets;       // Valid packets emitted
+    uint32_t skipped_bytes; // Bytes dropped while resynchronizing
+  };
+
+private:
+  uint8_t _buffer[CCSDS_MAX_PACKET_LENGTH];
+  uint16_t _start;           // Index of the first unprocessed byte
+  uint16_t _end;             // Index after the last buffered byte
+  uint16_t _emitted_length;  // Length of the last emitted packet, removed on the next call
+  Ccsds_Packet_View::Layout _layout;
+  Statistics _statistics;
+
+  void consume(uint16_t length);
+
+public:
+  /**
+   * @brief Create a new deframer
+   * @param layout Secondary header layout of the packets in the stream
+   */
+  Ccsds_Deframer(Ccsds_Packet_View::Layout layout = Ccsds_Packet_View::Layout::Telemetry);
+
+  /**
+   * @brief Copy stream bytes into the internal buffer
+   * @param data Pointer to stream bytes
+   * @param length Number of stream bytes
+   * @return Number of bytes accepted. Call next() until it returns false and then push the rest
+   */
+  size_t push(const uint8_t *data, size_t length);
+
+  /**
+   * @brief Find the next valid packet in the buffered data
+   * @param view View of the packet. Only valid until the next call to push() or next()
+   * @return True if a packet was found, false if more data is needed
+   */
+  bool next(Ccsds_Packet_View &view);
+
+  /**
+   * @brief Push a whole chunk of stream bytes and call a function for every valid packet found
+   * @param data Pointer to stream bytes
+   * @param length Number of stream bytes
+   * @param packet_function Function to call with every packet. The view is only valid during the call
+   * @return Number of packets found
+   */
+  uint32_t feed(const uint8_t *data, size_t length, void (*packet_function)(const Ccsds_Packet_View &));
+
+  /**
+   * @brief Drop all buffered data, for example when starting a new stream
+   */
+  void reset();
+
+  /**
+   * @brief Get the deframing statistics
+   * @return Statistics since creation or last reset
+   */
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,87 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+#include "Reed_solomon.h"
+
+/**
+ * @brief Optional forward error correction of CCSDS frames using interleaved shortened Reed-Solomon codewords.
+ * Wrap a packet with encode() before transmit_bytes() and unwrap it with decode() after receive_bytes().
+ *
+ * Frame layout: the packet bytes unchanged, followed by the parity symbols. Every frame byte p (packet
+ * or parity) belongs to codeword p % interleave_depth, so a burst of errors is spread over all codewords.
+ * Both ends must use the same config, the packet length is derived from the frame length.
+ *
+ * Each codeword can correct parity_symbols / 2 wrong bytes, so a frame can correct up to
+ * interleave_depth * parity_symbols / 2 wrong bytes, as long as they are spread evenly.
+ */
+class Ccsds_Fec
+{
+public:
+  struct Config
+  {
+    uint8_t parity_symbols;   // Parity symbols per codeword, even and at most REED_SOLOMON_MAX_PARITY_SYMBOLS
+    uint8_t interleave_depth; // Number of codewords per frame
+  };
+
+  struct Statistics
+  {
+    uint32_t frames;              // Frames decoded
+    uint32_t corrected_frames;    // Frames that had errors which were corrected
+    uint32_t uncorrectable_frames; // Frames with too many errors
+    uint32_t corrected_symbols;   // Total number of corrected bytes
+  };
+
+private:
+  Reed_Solomon _reed_solomon;
+  uint8_t _interleave_depth;
+  Statistics _statistics;
+
+  // Number of packet bytes in a codeword
+  uint8_t get_codeword_data_length(uint16_t packet_length, uint8_t codeword) const;
+  // Frame index of a parity symbol
+  uint16_t get_parity_index(uint16_t packet_length, uint8_t codeword, uint8_t symbol) const;
+
+public:
+  /**
+   * @brief Create a new FEC wrapper
+   * @param config FEC config
+   */
+  Ccsds_Fec(const Config &config);
+
+  /**
+   * @brief Add parity symbols to a packet
+   * @param packet Pointer to CCSDS packet byte array. Can be the same as frame
+   * @param packet_length Length of CCSDS packet
+   * @param frame Pointer to where the frame is written
+   * @param frame_size Size of the frame buffer
+   * @return Length of the frame or 0 if the packet is too long
+   */
+  uint16_t encode(const uint8_t *packet, uint16_t packet_length, uint8_t *frame, uint16_t frame_size) const;
+
+  /**
+   * @brief Correct errors in a received frame in place. The packet then starts at the beginning of the frame
+   * @param frame Pointer to received frame
+   * @param frame_length Length of received frame
+   * @param packet_length Set to the length of the packet inside the frame
+   * @return Number of corrected bytes or -1 if the frame has too many errors
+   */
+  int16_t decode(uint8_t *frame, uint16_t frame_length, uint16_t &packet_length);
+
+  /**
+   * @brief Get the longest packet that can be wrapped in a frame
+   * @param frame_size Maximum frame length
+   * @return Maximum packet length
+   */
+  uint16_t get_max_packet_length(uint16_t frame_size = CCSDS_MAX_FRAME_LENGTH) const;
+
+  /**
+   * @brief Get the number of bytes the FEC adds to every packet
+   * @return Parity bytes per frame
+   */
+  uint16_t get_overhead() const { return _reed_solomon.get_parity_symbols() * _interleave_depth; }
+
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,104 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+#include "Ccsds_payload.h"
+
+// Number of APIDs that can be tracked at once
+#ifndef CCSDS_LINK_STATISTICS_MAX_APIDS
+#define CCSDS_LINK_STATISTICS_MAX_APIDS 8
+#endif
+
+/**
+ * @brief Receive statistics of one APID. Kept compact so it can be logged or downlinked as is
+ */
+struct Ccsds_Apid_Statistics
+{
+  uint16_t apid;
+  uint16_t last_sequence_count; // Highest sequence count received (14 bits)
+  uint32_t received;            // Packets received, without duplicates
+  uint32_t expected;            // Packets the sender sent based on the sequence counts
+  uint32_t lost;                // Packets never received (expected - received)
+  uint16_t gaps;                // Number of times one or more packets were missing
+  uint16_t max_gap;             // Longest run of missing packets
+  uint16_t duplicates;          // Packets received more than once
+  uint16_t reordered;           // Packets received after a newer one
+  uint16_t resyncs;             // Times the sequence count jumped back too far to be reordering (sender restarted) or to before tracking started
+};
+
+// Layout and data format of Ccsds_Apid_Statistics when sent in a CCSDS packet
+using Ccsds_Apid_Statistics_Layout = Ccsds_Payload_Layout<uint16_t, uint16_t, uint32_t, uint32_t, uint32_t, uint16_t, uint16_t, uint16_t, uint16_t, uint16_t>;
+#define CCSDS_APID_STATISTICS_DATA_FORMAT "uint16,uint16,uint32,uint32,uint32,uint16,uint16,uint16,uint16,uint16"
+
+/**
+ * @brief Tracks the sequence counts of received packets per APID to measure link quality.
+ * 14-bit sequence count wraparound is handled, and duplicate and reordered packets
+ * are detected within the last 32 sequence counts.
+ */
+class Ccsds_Link_Statistics
+{
+private:
+  struct Tracker
+  {
+    Ccsds_Apid_Statistics statistics;
+    uint32_t received_window; // Bit n set if last_sequence_count - n was received
+    uint32_t expected_window; // Bit n set if last_sequence_count - n is counted in expected
+  };
+  Tracker _trackers[CCSDS_LINK_STATISTICS_MAX_APIDS];
+  uint8_t _tracker_count;
+
+public:
+  Ccsds_Link_Statistics();
+
+  /**
+   * @brief Record a received packet
+   * @param apid Application ID
+   * @param sequence_count Sequence count
+   * @return False if the APID is new and there is no space left to track it
+   */
+  bool update(uint16_t apid, uint16_t sequence_count);
+
+  /**
+   * @brief Record a received packet
+   * @param view Valid packet
+   * @return False if the APID is new and there is no space left to track it
+   */
+  bool update(const Ccsds_Packet_View &view) { return update(view.get_apid(), view.get_sequence_count()); }
+
+  /**
+   * @brief Get the statistics of one APID
+   * @param apid Application ID
+   * @return Pointer to the statistics or nullptr if nothing was received with this APID
+   */
+  const Ccsds_Apid_Statistics *get(uint16_t apid) const;
+
+  /**
+   * @brief Get the statistics by index, to go through all tracked APIDs
+   * @param index Index less than get_apid_count()
+   * @return Statistics
+   */
+  const Ccsds_Apid_Statistics &get_by_index(uint8_t index) const { return _trackers[index].statistics; }
+  uint8_t get_apid_count() const { return _tracker_count; }
+
+  /**
+   * @brief Remove all tracked APIDs
+   */
+  void reset();
+
+  /**
+   * @brief Calculate the share of lost packets
+   * @param statistics Statistics of an APID
+   * @return Lost packet ratio between 0 and 1
+   */
+  static float get_loss_ratio(const Ccsds_Apid_Statistics &statistics);
+
+  /**
+   * @brief Encode the statistics at the end of a packet being built, in the Ccsds_Apid_Statistics_Layout
+   * @param builder Packet builder after begin() was called
+   * @param statistics Statistics of an APID
+   * @return True if the statistics fit in the packet
+   */
+  static bool append(Ccsds_Packet_Builder &builder, const Ccsds_Apid_Statistics &statistics);
+};
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -1,6 +1,7 @@
 #pragma once
 #ifdef CCSDS_PACKETS_ENABLE
 #include <Arduino.h>
+#include "Crc16.h"
 
 // Union for converting between integer/float and byte array
 union Converter
@@ -9,7 +10,15 @@ union Converter
   uint16_t i16;
   uint8_t i8;
   float f;
-  byte b[4];
+  byte b[8];
+
+  // Signed and 64-bit values
+  int32_t s32;
+  int16_t s16;
+  int8_t s8;
+  uint64_t i64;
+  int64_t s64;
+  double d; // Also used for scaled fixed-point values
 };
 
 /**
@@ -37,13 +46,151 @@ void add_crc_16_cciit_to_ccsds_packet(uint8_t *&ccsds_packet, uint16_t ccsds_pac
 */
 bool check_crc_16_cciit_of_ccsds_packet(uint8_t *ccsds_packet, uint16_t &ccsds_packet_length);
 
+// Packet layout sizes in bytes
+const uint16_t CCSDS_PRIMARY_HEADER_LENGTH = 6;
+const uint16_t CCSDS_SECONDARY_HEADER_LENGTH = 6;
+const uint16_t CCSDS_TELEMETRY_HEADER_LENGTH = CCSDS_PRIMARY_HEADER_LENGTH + CCSDS_SECONDARY_HEADER_LENGTH;
+const uint16_t CCSDS_CRC_LENGTH = 2;
+const uint16_t CCSDS_MAX_FRAME_LENGTH = 255;                   // LoRa max payload length of a single radio frame
+const uint16_t CCSDS_MAX_PACKET_LENGTH = CCSDS_MAX_FRAME_LENGTH; // A packet has to fit in a single frame
+const uint16_t CCSDS_MAX_TELEMETRY_DATA_LENGTH = CCSDS_MAX_PACKET_LENGTH - CCSDS_TELEMETRY_HEADER_LENGTH - CCSDS_CRC_LENGTH;
+
+// Primary header sequence flags, showing which part of a segmented user data block a packet carries
+enum class Ccsds_Sequence_Flags : uint8_t
+{
+  Continuation = 0,
+  First = 1,
+  Last = 2,
+  Unsegmented = 3,
+};
+
+/**
+ * @brief Write a CCSDS primary header into a buffer
+ * @param buffer Pointer to at least CCSDS_PRIMARY_HEADER_LENGTH bytes
+ * @param apid Application ID
+ * @param sequence_count Sequence count
+ * @param data_length Length of data in packet
+ * @param sequence_flags Segmentation of the packet. Unsegmented unless using Ccsds_Segmenter
+ */
+void write_ccsds_primary_header(uint8_t *buffer, uint16_t apid, uint16_t sequence_count, uint16_t data_length, Ccsds_Sequence_Flags sequence_flags = Ccsds_Sequence_Flags::Unsegmented);
+
+/**
+ * @brief Write a CCSDS secondary header into a buffer
+ * @param buffer Pointer to at least CCSDS_SECONDARY_HEADER_LENGTH bytes
+ * @param gps_epoch_time GPS epoch time
+ * @param subseconds Subseconds
+ */
+void write_ccsds_secondary_header(uint8_t *buffer, uint32_t gps_epoch_time, uint16_t subseconds);
+
+/**
+ * @brief Builds a CCSDS telemetry packet in place in a caller owned buffer, without any heap allocation
+ * @note Usage: begin(), then append()/reserve() the data, then finish() to get the packet length
+ */
+class Ccsds_Packet_Builder
+{
+private:
+  uint8_t *_buffer;
+  uint16_t _buffer_size;
+  uint16_t _length;
+  bool _overflow;
+
+  uint16_t _apid;
+  uint16_t _sequence_count;
+  Ccsds_Sequence_Flags _sequence_flags;
+
+public:
+  /**
+   * @brief Create a builder writing into the given buffer
+   * @param buffer Pointer to packet byte array. Must stay valid while the builder is used
+   * @param buffer_size Size of the buffer
+   */
+  Ccsds_Packet_Builder(uint8_t *buffer, uint16_t buffer_size);
+
+  /**
+   * @brief Start a new telemetry packet, writing the secondary header
+   * @param apid Application ID
+   * @param sequence_count Sequence count
+   * @param gps_epoch_time GPS epoch time
+   * @param subseconds Subseconds (0-65535 fraction of a second)
+   * @return True if the headers fit in the buffer
+   */
+  bool begin(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds);
+
+  /**
+   * @brief Mark the packet as a segment of a larger user data block. Call after begin()
+   * @param sequence_flags Segmentation of the packet
+   */
+  void set_sequence_flags(Ccsds_Sequence_Flags sequence_flags) { _sequence_flags = sequence_flags; }
+
+  /**
+   * @brief Append bytes to the packet data
+   * @param data Pointer to data byte array
+   * @param length Length of data
+   * @return True if the data fit in the buffer. If not, the packet is marked as overflowed
+   */
+  bool append(const uint8_t *data, uint16_t length);
+
+  /**
+   * @brief Reserve space at the end of the packet data to be written directly by the caller
+   * @param length Number of bytes to reserve
+   * @return Pointer to the reserved bytes or nullptr if they don't fit in the buffer
+   */
+  uint8_t *reserve(uint16_t length);
+
+  /**
+   * @brief Write the primary header and checksum
+   * @return Length of the full CCSDS packet or 0 if the packet didn't fit in the buffer
+   */
+  uint16_t finish();
+
+  /**
+   * @brief Get the length of data appended so far
+   * @return Data length in bytes
+   */
+  uint16_t get_data_length() const { return _length - CCSDS_TELEMETRY_HEADER_LENGTH; }
+
+  /**
+   * @brief Get the number of data bytes that can still be appended
+   * @return Free space in bytes, accounting for the checksum
+   */
+  uint16_t get_remaining_length() const;
+};
+
+/**
+ * @brief Build a full CCSDS telemetry packet with checksum in a caller owned buffer
+ * @param buffer Pointer to packet byte array. CCSDS_MAX_PACKET_LENGTH bytes is always enough
+ * @param buffer_size Size of the buffer
+ * @param apid Application ID
+ * @param sequence_count Sequence count
+ * @param gps_epoch_time GPS epoch time
+ * @param subseconds Subseconds (0-65535 fraction of a second)
+ * @param data Pointer to already encoded data byte array
+ * @param data_length Length of data
+ * @return Length of CCSDS packet or 0 if it doesn't fit in the buffer
+ */
+uint16_t build_ccsds_telemetry_packet(uint8_t *buffer, uint16_t buffer_size, uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const uint8_t *data, uint16_t data_length);
+
+/**
+ * @brief Build a full CCSDS telemetry packet with checksum in a caller owned buffer
+ * @param buffer Pointer to packet byte array. CCSDS_MAX_PACKET_LENGTH bytes is always enough
+ * @param buffer_size Size of the buffer
+ * @param apid Application ID
+ * @param sequence_count Sequence count
+ * @param gps_epoch_time GPS epoch time
+ * @param subseconds Subseconds (0-65535 fraction of a second)
+ * @param data String of comma seperated values to be converted to byte array
+ * @return Length of CCSDS packet or 0 if it doesn't fit in the buffer
+ * @note Kept for compatibility. Ccsds_Payload_Layout from Ccsds_payload.h encodes typed values without the String round trip
+ */
+uint16_t build_ccsds_telemetry_packet(uint8_t *buffer, uint16_t buffer_size, uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const String &data);
+
 /**
  * @brief Create a CCSDS primary header
  * @param apid Application ID
  * @param sequence_count Sequence count
  * @param data_length Length of data in packet
  * @return Pointer to primary header byte array
- * @note The primary header must be deleted after use
+ * @note The primary header must be deleted after use. Prefer write_ccsds_primary_header()
  */
 byte *create_ccsds_primary_header(uint16_t apid, uint16_t sequence_count, uint16_t data_length);
 
@@ -52,7 +199,7 @@ byte *create_ccsds_primary_header(uint16_t apid, uint16_t sequence_count, uint16
  * @param gps_epoch_time GPS epoch time
  * @param subseconds Subseconds
  * @return Pointer to secondary header byte array
- * @note The secondary header must be deleted after use
+ * @note The secondary header must be deleted after use. Prefer write_ccsds_secondary_header()
  */
 byte *create_ccsds_secondary_header(uint32_t gps_epoch_time, uint16_t subseconds);
 
@@ -64,11 +211,84 @@ byte *create_ccsds_secondary_header(uint32_t gps_epoch_time, uint16_t subseconds
  * @param subseconds Subseconds (0-65535 fraction of a second)
  * @param data String of comma seperated values to be converted to byte array
  * @param ccsds_packet_length Length of CCSDS packet
- * @return Pointer to CCSDS packet byte array
- * @note The CCSDS packet must be deleted after use
+ * @return Pointer to CCSDS packet byte array or nullptr if the data doesn't fit in one packet
+ * @note The CCSDS packet must be deleted after use. Prefer build_ccsds_telemetry_packet(), which doesn't allocate
  */
 byte *create_ccsds_telemetry_packet(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, String data, uint16_t &ccsds_packet_length);
 
+/**
+ * @brief Non-owning view over a received CCSDS packet. Header fields are decoded when accessed
+ * and the data points into the original frame, so nothing is allocated or copied
+ * @note The frame must stay valid while the view is used
+ */
+class Ccsds_Packet_View
+{
+public:
+  // Secondary header layout
+  enum class Layout
+  {
+    Telemetry,   // GPS epoch time and subseconds (6 bytes)
+    Telecommand, // Packet id (2 bytes)
+  };
+
+private:
+  const uint8_t *_frame;
+  uint16_t _frame_length;
+  Layout _layout;
+
+public:
+  /**
+   * @brief Create a view over a received frame
+   * @param frame Pointer to the frame byte array, starting at the primary header
+   * @param frame_length Number of bytes available in the frame
+   * @param layout Secondary header layout of the packet
+   */
+  Ccsds_Packet_View(const uint8_t *frame = nullptr, uint16_t frame_length = 0, Layout layout = Layout::Telemetry)
+      : _frame(frame), _frame_length(frame_length), _layout(layout) {}
+
+  /**
+   * @brief Check that the frame holds the full packet declared in the primary header and that its checksum is correct
+   * @return True if the packet can be used
+   */
+  bool is_valid() const;
+
+  // Primary header fields. Only use after checking that the frame holds at least the primary header
+  uint8_t get_version() const { return (_frame[0] >> 5) & 0x07; }
+  bool is_telecommand() const { return (_frame[0] >> 4) & 0x01; }
+  bool has_secondary_header() const { return (_frame[0] >> 3) & 0x01; }
+  uint16_t get_apid() const { return ((_frame[0] & 0x07) << 8) | _frame[1]; }
+  uint8_t get_sequence_flags() const { return (_frame[2] >> 6) & 0x03; }
+  uint16_t get_sequence_count() const { return ((_frame[2] << 8) | _frame[3]) & 0x3FFF; }
+  uint16_t get_data_length() const { return (_frame[4] << 8) | _frame[5]; }
+
+  // Secondary header fields. Only use after is_valid()
+  uint32_t get_gps_epoch_time() const;
+  uint16_t get_subseconds() const;
+  uint16_t get_packet_id() const;
+
+  /**
+   * @brief Get the length of the primary and secondary headers for the layout
+   * @return Header length in bytes
+   */
+  uint16_t get_header_length() const;
+
+  /**
+   * @brief Get the full packet length declared by the primary header, including the checksum
+   * @return Packet length in bytes
+   */
+  uint32_t get_packet_length() const { return get_header_length() + static_cast<uint32_t>(get_data_length()) + CCSDS_CRC_LENGTH; }
+
+  /**
+   * @brief Get the packet data
+   * @return Pointer into the frame where the data starts or nullptr if there is no data
+   */
+  const uint8_t *get_data() const { return get_data_length() == 0 ? nullptr : _frame + get_header_length(); }
+
+  const uint8_t *get_frame() const { return _frame; }
+  uint16_t get_frame_length() const { return _frame_length; }
+  Layout get_layout() const { return _layout; }
+};
+
 /**
  * @brief Parse a CCSDS packet, extracting the primary header, secondary header, and data
  * @param packet Pointer to CCSDS packet byte array
@@ -78,7 +298,7 @@ byte *create_ccsds_telemetry_packet(uint16_t apid, uint16_t sequence_count, uint
  * @param subseconds Subseconds
  * @param ccsds_data Pointer to data byte array
  * @param data_length Length of data in packet
- * @note The data must be deleted after use
+ * @note The data must be deleted after use. Ccsds_Packet_View avoids the allocation and copy
  */
 void parse_ccsds_telemetry(byte *packet, uint16_t &apid, uint16_t &sequence_count, uint32_t &gps_epoch_time, uint16_t &subseconds, byte *&ccsds_data, uint16_t &data_length);
 
@@ -89,7 +309,7 @@ void parse_ccsds_telemetry(byte *packet, uint16_t &apid, uint16_t &sequence_coun
  * @param sequence_count Sequence count
  * @param ccsds_data Pointer to data byte array
  * @param data_length Length of data in packet
- * @note The data must be deleted after use
+ * @note The data must be deleted after use. Ccsds_Packet_View avoids the allocation and copy
  */
 void parse_ccsds_telecommand(byte *packet, uint16_t &apid, uint16_t &sequence_count, uint16_t &packet_id, byte *&ccsds_data, uint16_t &data_length);
 
@@ -98,9 +318,110 @@ void parse_ccsds_telecommand(byte *packet, uint16_t &apid, uint16_t &sequence_co
  * @param ccsds_data Pointer to data byte array
  * @param data_values Pointer to data values array
  * @param data_format String of comma seperated data types. Example: "float,uint8,uint16,uint32"
+ * Unknown data types are skipped: their value is left unchanged and no bytes are read for them
+ * @note The format is parsed on every call and the data length isn't checked. When decoding many packets
+ * with the same format use compile_ccsds_decode_plan() once and the plan overload of this function
  */
 void extract_ccsds_data_values(byte *ccsds_data, Converter *data_values, String data_format);
 
+// Data types that can be decoded from CCSDS packet data
+enum class Ccsds_Field_Type : uint8_t
+{
+  Float,
+  Uint8,
+  Uint16,
+  Uint32,
+  Int8,
+  Int16,
+  Int32,
+  Int64,
+  Uint64,
+  Double,
+};
+
+const uint8_t CCSDS_DECODE_PLAN_MAX_FIELDS = 64;
+const uint8_t CCSDS_DECODE_PLAN_MAX_SCALES = 8;
+const uint8_t CCSDS_DECODE_PLAN_NO_SCALE = 0xFF;
+
+// Precompiled data format, so packets can be decoded without parsing the format String again
+struct Ccsds_Decode_Plan
+{
+  struct Field
+  {
+    Ccsds_Field_Type type;
+    uint8_t scale_index; // Index in scales for fixed-point fields, CCSDS_DECODE_PLAN_NO_SCALE otherwise
+    uint16_t offset;     // Offset of the value from the start of the packet data
+  };
+  Field fields[CCSDS_DECODE_PLAN_MAX_FIELDS];
+  double scales[CCSDS_DECODE_PLAN_MAX_SCALES]; // Distinct fixed-point scales, shared by fields
+  uint8_t field_count = 0;
+  uint8_t scale_count = 0;
+  uint16_t data_length = 0; // Number of data bytes needed to decode all fields
+};
+
+/**
+ * @brief Get the encoded size of a data type
+ * @param type Data type
+ * @return Size in bytes
+ */
+uint8_t get_ccsds_field_size(Ccsds_Field_Type type);
+
+/**
+ * @brief Check if a data type is a signed integer
+ * @param type Data type
+ * @return True for Int8, Int16, Int32 and Int64
+ */
+bool is_ccsds_field_signed(Ccsds_Field_Type type);
+
+/**
+ * @brief Compile a data format String into a decode plan
+ * @param data_format String of comma seperated data types. Example: "float,uint8,uint16,uint32"
+ * Supported types: float, double, uint8, uint16, uint32, uint64, int8, int16, int32, int64.
+ * An integer type followed by *scale is a fixed-point value, decoded as a double into Converter::d.
+ * Example: "int32*1e-7,int32*1e-7,int16*0.1" for latitude, longitude and altitude in decimetres
+ * @param plan Plan to fill. On failure it contains the fields before the invalid one
+ * @return True if all data types are known and fit in the plan
+ */
+bool compile_ccsds_decode_plan(const String &data_format, Ccsds_Decode_Plan &plan);
+
+/**
+ * @brief Read a CCSDS packet data using a precompiled decode plan. No parsing or allocation is done
+ * @param ccsds_data Pointer to data byte array
+ * @param data_length Length of data in packet
+ * @param data_values Pointer to data values array with at least plan.field_count elements
+ * @param plan Decode plan from compile_ccsds_decode_plan()
+ * @return True if the data was long enough for the plan. If not, nothing is decoded
+ */
+bool extract_ccsds_data_values(const uint8_t *ccsds_data, uint16_t data_length, Converter *data_values, const Ccsds_Decode_Plan &plan);
+
+/**
+ * @brief Get the raw encoded bits of a value, converting fixed-point values from Converter::d
+ * @param data_value Value as used by extract_ccsds_data_values()
+ * @param plan Decode plan describing the data types
+ * @param index Field index in the plan
+ * @return Raw value in the lowest bits
+ */
+uint64_t get_ccsds_field_raw_value(const Converter &data_value, const Ccsds_Decode_Plan &plan, uint8_t index);
+
+/**
+ * @brief Set a value from its raw encoded bits, sign extending and scaling as needed
+ * @param data_value Value as used by extract_ccsds_data_values()
+ * @param raw_value Raw value in the lowest bits
+ * @param plan Decode plan describing the data types
+ * @param index Field index in the plan
+ */
+void set_ccsds_field_raw_value(Converter &data_value, uint64_t raw_value, const Ccsds_Decode_Plan &plan, uint8_t index);
+
+/**
+ * @brief Write values into CCSDS packet data using a decode plan as the layout (MSB first)
+ * @param ccsds_data Pointer to data byte array
+ * @param data_length Size of the data byte array
+ * @param data_values Pointer to data values array with at least plan.field_count elements
+ * @param plan Decode plan describing the data types
+ * @return Number of bytes written or 0 if the data byte array is too small
+ */
+uint16_t write_ccsds_data_values(uint8_t *ccsds_data, uint16_t data_length, const Converter *data_values, const Ccsds_Decode_Plan &plan);
+
 /**
  * @brief Read a CCSDS telemetry packet data, extract the position data
  * @param ccsds_data Pointer to data byte array
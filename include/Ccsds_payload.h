@@ -0,0 +1,252 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+#include <limits>
+
+/*
+  Compile time typed CCSDS payload encoding.
+
+  Instead of formatting values to a comma seperated String and parsing them back,
+  the payload layout is declared as a list of types and the values are packed
+  big-endian (MSB first) directly into the packet. The payload size is known at compile time.
+
+  Example:
+    using Position_Layout = Ccsds_Payload_Layout<float, float, float, uint8_t>;
+    uint8_t packet[CCSDS_MAX_PACKET_LENGTH];
+    uint16_t length = Position_Layout::build(packet, sizeof(packet), apid, sequence_count, gps_epoch_time, subseconds, lat, lng, altitude, satellites);
+
+  Fixed-point fields send less data than floats with a known resolution:
+    using Compact_Position_Layout = Ccsds_Payload_Layout<Ccsds_Fixed_Point<int32_t, 10000000>, Ccsds_Fixed_Point<int32_t, 10000000>, Ccsds_Fixed_Point<int16_t, 10>>;
+    Compact_Position_Layout::encode(data, lat, lng, altitude); // Decoded with "int32*1e-7,int32*1e-7,int16*0.1"
+*/
+
+/**
+ * @brief Describes how a single value is stored in a CCSDS payload
+ * @note Only the specialized types can be used in a payload layout
+ */
+template <typename T>
+struct Ccsds_Field;
+
+template <>
+struct Ccsds_Field<uint8_t>
+{
+  static constexpr uint16_t size = 1;
+  static void write(uint8_t *buffer, uint8_t value) { buffer[0] = value; }
+};
+
+template <>
+struct Ccsds_Field<int8_t>
+{
+  static constexpr uint16_t size = 1;
+  static void write(uint8_t *buffer, int8_t value) { Ccsds_Field<uint8_t>::write(buffer, static_cast<uint8_t>(value)); }
+};
+
+template <>
+struct Ccsds_Field<uint16_t>
+{
+  static constexpr uint16_t size = 2;
+  static void write(uint8_t *buffer, uint16_t value)
+  {
+    buffer[0] = (value >> 8) & 0xFF;
+    buffer[1] = value & 0xFF;
+  }
+};
+
+template <>
+struct Ccsds_Field<int16_t>
+{
+  static constexpr uint16_t size = 2;
+  static void write(uint8_t *buffer, int16_t value) { Ccsds_Field<uint16_t>::write(buffer, static_cast<uint16_t>(value)); }
+};
+
+template <>
+struct Ccsds_Field<uint32_t>
+{
+  static constexpr uint16_t size = 4;
+  static void write(uint8_t *buffer, uint32_t value)
+  {
+    buffer[0] = (value >> 24) & 0xFF;
+    buffer[1] = (value >> 16) & 0xFF;
+    buffer[2] = (value >> 8) & 0xFF;
+    buffer[3] = value & 0xFF;
+  }
+};
+
+template <>
+struct Ccsds_Field<int32_t>
+{
+  static constexpr uint16_t size = 4;
+  static void write(uint8_t *buffer, int32_t value) { Ccsds_Field<uint32_t>::write(buffer, static_cast<uint32_t>(value)); }
+};
+
+template <>
+struct Ccsds_Field<float>
+{
+  static constexpr uint16_t size = 4;
+  static void write(uint8_t *buffer, float value)
+  {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Ccsds_Field<uint32_t>::write(buffer, bits);
+  }
+};
+
+template <>
+struct Ccsds_Field<uint64_t>
+{
+  static constexpr uint16_t size = 8;
+  static void write(uint8_t *buffer, uint64_t value)
+  {
+    Ccsds_Field<uint32_t>::write(buffer, static_cast<uint32_t>(value >> 32));
+    Ccsds_Field<uint32_t>::write(buffer + 4, static_cast<uint32_t>(value));
+  }
+};
+
+template <>
+struct Ccsds_Field<int64_t>
+{
+  static constexpr uint16_t size = 8;
+  static void write(uint8_t *buffer, int64_t value) { Ccsds_Field<uint64_t>::write(buffer, static_cast<uint64_t>(value)); }
+};
+
+#if __SIZEOF_DOUBLE__ == 8 // On some MCUs double is the same as float
+template <>
+struct Ccsds_Field<double>
+{
+  static constexpr uint16_t size = 8;
+  static void write(uint8_t *buffer, double value)
+  {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Ccsds_Field<uint64_t>::write(buffer, bits);
+  }
+};
+#endif
+
+/**
+ * @brief Fixed-point value, stored as an integer number of 1 / Units_Per_One steps
+ * @note Matches the "type*scale" format of compile_ccsds_decode_plan with scale = 1 / Units_Per_One.
+ *       For example Ccsds_Fixed_Point<int32_t, 10000000> is "int32*1e-7"
+ * @tparam Raw Integer type sent in the packet
+ * @tparam Units_Per_One Number of steps in 1.0
+ */
+template <typename Raw, uint32_t Units_Per_One>
+struct Ccsds_Fixed_Point
+{
+  Raw raw;
+
+  /**
+   * @brief Convert a value to fixed-point, rounding to the nearest step
+   * @param value Value to convert. Values outside the range of Raw are saturated
+   */
+  Ccsds_Fixed_Point(double value)
+  {
+    double scaled = value * Units_Per_One;
+    scaled = scaled < 0 ? scaled - 0.5 : scaled + 0.5;
+    if (scaled >= static_cast<double>(std::numeric_limits<Raw>::max()))
+    {
+      raw = std::numeric_limits<Raw>::max();
+    }
+    else if (scaled <= static_cast<double>(std::numeric_limits<Raw>::min()))
+    {
+      raw = std::numeric_limits<Raw>::min();
+    }
+    else
+    {
+      raw = static_cast<Raw>(scaled);
+    }
+  }
+
+  double get_value() const { return static_cast<double>(raw) / Units_Per_One; }
+};
+
+template <typename Raw, uint32_t Units_Per_One>
+struct Ccsds_Field<Ccsds_Fixed_Point<Raw, Units_Per_One>>
+{
+  static constexpr uint16_t size = Ccsds_Field<Raw>::size;
+  static void write(uint8_t *buffer, Ccsds_Fixed_Point<Raw, Units_Per_One> value) { Ccsds_Field<Raw>::write(buffer, value.raw); }
+};
+
+/**
+ * @brief Total encoded size of a list of field types
+ */
+template <typename... Fields>
+struct Ccsds_Payload_Size;
+
+template <>
+struct Ccsds_Payload_Size<>
+{
+  static constexpr uint16_t value = 0;
+};
+
+template <typename First, typename... Rest>
+struct Ccsds_Payload_Size<First, Rest...>
+{
+  static constexpr uint16_t value = Ccsds_Field<First>::size + Ccsds_Payload_Size<Rest...>::value;
+};
+
+/**
+ * @brief A CCSDS payload layout declared as a list of field types
+ * @tparam Fields Types of the values in the order they are stored in the packet
+ */
+template <typename... Fields>
+struct Ccsds_Payload_Layout
+{
+  // Encoded payload size in bytes
+  static constexpr uint16_t size = Ccsds_Payload_Size<Fields...>::value;
+  static_assert(size <= CCSDS_MAX_TELEMETRY_DATA_LENGTH, "CCSDS payload layout doesn't fit in a single packet");
+
+  /**
+   * @brief Encode the values big-endian into a buffer
+   * @param buffer Pointer to at least size bytes
+   * @param values Values to encode
+   * @return Number of bytes written (always size)
+   */
+  static uint16_t encode(uint8_t *buffer, Fields... values)
+  {
+    uint16_t offset = 0;
+    // Braced initializer lists are evaluated in order, so the fields are written one after another
+    int expand[] = {0, (Ccsds_Field<Fields>::write(buffer + offset, values), offset += Ccsds_Field<Fields>::size, 0)...};
+    (void)expand;
+    return offset;
+  }
+
+  /**
+   * @brief Encode the values directly at the end of a packet being built
+   * @param builder Packet builder after begin() was called
+   * @param values Values to encode
+   * @return True if the values fit in the packet
+   */
+  static bool append(Ccsds_Packet_Builder &builder, Fields... values)
+  {
+    uint8_t *destination = builder.reserve(size);
+    if (destination == nullptr)
+    {
+      return false;
+    }
+    encode(destination, values...);
+    return true;
+  }
+
+  /**
+   * @brief Build a full CCSDS telemetry packet with checksum containing the values
+   * @param buffer Pointer to packet byte array
+   * @param buffer_size Size of the buffer
+   * @param apid Application ID
+   * @param sequence_count Sequence count
+   * @param gps_epoch_time GPS epoch time
+   * @param subseconds Subseconds (0-65535 fraction of a second)
+   * @param values Values to encode
+   * @return Length of CCSDS packet or 0 if it doesn't fit in the buffer
+   */
+  static uint16_t build(uint8_t *buffer, uint16_t buffer_size, uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, Fields... values)
+  {
+    Ccsds_Packet_Builder builder(buffer, buffer_size);
+    builder.begin(apid, sequence_count, gps_epoch_time, subseconds);
+    append(builder, values...);
+    return builder.finish();
+  }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
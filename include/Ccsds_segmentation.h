@@ -0,0 +1,155 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+
+// Number of APIDs that can be reassembled at the same time
+#ifndef CCSDS_REASSEMBLY_SLOTS
+#define CCSDS_REASSEMBLY_SLOTS 2
+#endif
+
+// Largest user data block that can be reassembled, in bytes
+#ifndef CCSDS_REASSEMBLY_MAX_LENGTH
+#define CCSDS_REASSEMBLY_MAX_LENGTH 2048
+#endif
+
+/**
+ * @brief Splits a user data block that is larger than one radio frame into CCSDS segments
+ * (first, continuation..., last). A block that fits in one packet is sent unsegmented.
+ *
+ * Example:
+ *   segmenter.begin(apid, sequence_count, gps_epoch_time, subseconds, log_tail, log_tail_length);
+ *   while (!segmenter.is_done())
+ *   {
+ *     uint16_t length = segmenter.next(packet, sizeof(packet));
+ *     // Wait for the previous segment to finish sending, but give up if the radio keeps failing.
+ *     // The receiver drops the incomplete block on the sequence gap or after its timeout
+ *     unsigned long start_time = millis();
+ *     bool sent = false;
+ *     while (!(sent = radio.transmit_bytes(packet, length)) && millis() - start_time < 1000) {}
+ *     if (!sent)
+ *     {
+ *       break;
+ *     }
+ *   }
+ *   sequence_count = segmenter.get_sequence_count();
+ */
+class Ccsds_Segmenter
+{
+private:
+  const uint8_t *_data;
+  uint32_t _length;
+  uint32_t _offset;
+  bool _started;
+
+  uint16_t _apid;
+  uint16_t _sequence_count;
+  uint32_t _gps_epoch_time;
+  uint16_t _subseconds;
+  uint16_t _max_packet_length;
+
+public:
+  Ccsds_Segmenter();
+
+  /**
+   * @brief Start segmenting a new user data block
+   * @param apid Application ID
+   * @param sequence_count Sequence count of the first segment. Each segment uses the next one
+   * @param gps_epoch_time GPS epoch time put in every segment
+   * @param subseconds Subseconds put in every segment
+   * @param data Pointer to the user data block. Must stay valid until is_done()
+   * @param length Length of the user data block
+   * @param max_packet_length Maximum length of a single segment packet, at most one radio frame
+   * @return True if the block can be segmented
+   */
+  bool begin(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const uint8_t *data, uint32_t length, uint16_t max_packet_length = CCSDS_MAX_FRAME_LENGTH);
+
+  /**
+   * @brief Build the next segment packet
+   * @param buffer Pointer to packet byte array
+   * @param buffer_size Size of the buffer
+   * @return Length of the segment packet or 0 if there are no more segments or the buffer is too small
+   */
+  uint16_t next(uint8_t *buffer, uint16_t buffer_size);
+
+  /**
+   * @brief Check if all segments have been built
+   * @return True if done
+   */
+  bool is_done() const { return !_started || _offset >= _length; }
+
+  /**
+   * @brief Get the sequence count the next packet with this APID should use
+   * @return Sequence count (14 bits)
+   */
+  uint16_t get_sequence_count() const { return _sequence_count; }
+};
+
+/**
+ * @brief Reassembles segmented CCSDS packets back into user data blocks.
+ * Up to CCSDS_REASSEMBLY_SLOTS APIDs can be in progress at once, each limited to
+ * CCSDS_REASSEMBLY_MAX_LENGTH bytes. Incomplete blocks are dropped on a sequence gap or after a timeout.
+ */
+class Ccsds_Reassembler
+{
+public:
+  enum class Result
+  {
+    Incomplete, // Segment stored, waiting for the rest
+    Complete,   // A full user data block is available
+    Dropped,    // Segment couldn't be used (gap, overflow, no free slot or no first segment)
+  };
+
+  struct Statistics
+  {
+    uint32_t completed;
+    uint32_t timed_out;
+    uint32_t sequence_gaps;
+    uint32_t overflows;
+    uint32_t no_free_slot;
+  };
+
+private:
+  struct Slot
+  {
+    bool in_use;
+    uint16_t apid;
+    uint16_t next_sequence_count;
+    unsigned long last_update_time;
+    uint32_t length;
+    uint8_t data[CCSDS_REASSEMBLY_MAX_LENGTH];
+  };
+  Slot _slots[CCSDS_REASSEMBLY_SLOTS];
+  Slot *_completed_slot; // Freed on the next call, so the returned data stays valid until then
+  unsigned long _timeout;
+  Statistics _statistics;
+
+  Slot *find_slot(uint16_t apid);
+
+public:
+  /**
+   * @brief Create a new reassembler
+   * @param timeout Time in ms after the last received segment when an incomplete block is dropped
+   */
+  Ccsds_Reassembler(unsigned long timeout = 5000);
+
+  /**
+   * @brief Add a received packet
+   * @param view Valid packet
+   * @param data Set to the full user data block if the result is Complete. Valid until the next call
+   * @param length Set to the length of the user data block if the result is Complete
+   * @param now Current time in ms
+   * @return Reassembly result. Unsegmented packets are returned as Complete without copying
+   */
+  Result add(const Ccsds_Packet_View &view, const uint8_t *&data, uint32_t &length, unsigned long now = millis());
+
+  /**
+   * @brief Drop incomplete blocks that haven't received a segment within the timeout
+   * @param now Current time in ms
+   */
+  void check_timeouts(unsigned long now = millis());
+
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
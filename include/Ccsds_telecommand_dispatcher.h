@@ -0,0 +1,88 @@
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Ccsds_packets.h"
+
+// Number of lookup table slots. Must be a power of two. At most half of them can hold handlers
+#ifndef CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE
+#define CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE 64
+#endif
+
+/**
+ * @brief Calls the registered handler of a telecommand based on its APID and packet id.
+ * Handlers are stored in a fixed size hash table, so finding one takes the same time regardless
+ * of how many commands are registered and nothing is allocated.
+ *
+ * Example:
+ *   void deploy_recovery(const Ccsds_Packet_View &telecommand) { ... }
+ *   dispatcher.register_handler(100, 1, deploy_recovery, 1000); // At most once per second
+ *   ...
+ *   if (radio.receive_bytes(frame, length, rssi, snr, frequency)) dispatcher.dispatch(frame, length);
+ */
+class Ccsds_Telecommand_Dispatcher
+{
+public:
+  // The view points into the received frame and is only valid during the call
+  typedef void (*Handler)(const Ccsds_Packet_View &telecommand);
+
+  enum class Result
+  {
+    Handled,         // Handler was called
+    Invalid_Packet,  // Length or checksum wrong
+    Unknown_Command, // No handler registered for the APID and packet id
+    Rate_Limited,    // Handler was called too recently
+  };
+
+private:
+  static_assert((CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE & (CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE - 1)) == 0, "Dispatcher table size must be a power of two");
+  static_assert(CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE <= 256, "Dispatcher table size must be at most 256");
+
+  struct Entry
+  {
+    Handler handler; // nullptr if the slot is free
+    uint16_t apid;
+    uint16_t packet_id;
+    unsigned long min_interval;
+    unsigned long last_call_time;
+    bool called;
+  };
+  Entry _entries[CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE];
+  uint8_t _handler_count;
+
+  static uint8_t get_hash(uint16_t apid, uint16_t packet_id);
+  Entry *find_entry(uint16_t apid, uint16_t packet_id);
+
+public:
+  Ccsds_Telecommand_Dispatcher();
+
+  /**
+   * @brief Register the handler of a command. Registering the same command again replaces its handler
+   * @param apid Application ID
+   * @param packet_id Packet id
+   * @param handler Function to call when the command is received
+   * @param min_interval Minimum time in ms between handler calls. Commands received sooner are ignored (0 - no limit)
+   * @return False if the table is full
+   */
+  bool register_handler(uint16_t apid, uint16_t packet_id, Handler handler, unsigned long min_interval = 0);
+
+  /**
+   * @brief Call the handler of a validated telecommand
+   * @param telecommand Telecommand packet with the Telecommand layout
+   * @param now Current time in ms, used for rate limiting
+   * @return Dispatch result
+   */
+  Result dispatch(const Ccsds_Packet_View &telecommand, unsigned long now = millis());
+
+  /**
+   * @brief Validate a received frame and call the handler of the telecommand in it
+   * @param frame Pointer to the received frame
+   * @param frame_length Length of the received frame
+   * @param now Current time in ms, used for rate limiting
+   * @return Dispatch result
+   */
+  Result dispatch(const uint8_t *frame, uint16_t frame_length, unsigned long now = millis());
+
+  uint8_t get_handler_count() const { return _handler_count; }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,51 @@
+/*
+  Helpers for generating lookup tables at compile time with C++11 constexpr.
+
+  C++11 constexpr constructors can't contain loops, so the tables are built by expanding
+  an index list in the member initializer list instead:
+
+    template <uint16_t... Indices>
+    constexpr Table(Compile_Time_Table::Index_List<Indices...>) : entries{calculate_entry(Indices)...} {}
+
+  The index list is generated by halving, so the template instantiation depth only grows
+  with log2 of the table size.
+*/
+#pragma once
+#include <Arduino.h>
+
+namespace Compile_Time_Table
+{
+  template <uint16_t... Indices>
+  struct Index_List
+  {
+  };
+
+  // Append the second list to the first one, offset by the length of the first list
+  template <typename First, typename Second>
+  struct Concat;
+
+  template <uint16_t... First, uint16_t... Second>
+  struct Concat<Index_List<First...>, Index_List<Second...>>
+  {
+    using type = Index_List<First..., static_cast<uint16_t>(sizeof...(First) + Second)...>;
+  };
+
+  // Index_List<0, 1, ..., Length - 1>
+  template <uint16_t Length>
+  struct Make_Index_List
+  {
+    using type = typename Concat<typename Make_Index_List<Length / 2>::type, typename Make_Index_List<Length - Length / 2>::type>::type;
+  };
+
+  template <>
+  struct Make_Index_List<0>
+  {
+    using type = Index_List<>;
+  };
+
+  template <>
+  struct Make_Index_List<1>
+  {
+    using type = Index_List<0>;
+  };
+}
@@ -0,0 +1,222 @@
+/*
+  Table driven CRC-16 engine shared by the CCSDS packets and the RadioLib wrapper checksums.
+
+  The lookup tables are generated at compile time, so no initialization is needed at runtime.
+  Three table layouts are available, trading flash usage for speed:
+    - Nibble     - 16 entries (32 bytes), two lookups per byte. For flash constrained MCUs
+    - Byte       - 256 entries (512 bytes), one lookup per byte. Default
+    - Slice_By_4 - 4 x 256 entries (2 KB), processes 4 bytes per iteration
+
+  The default layout can be changed for the whole project by defining CRC16_TABLE_NIBBLE or
+  CRC16_TABLE_SLICE_BY_4 in the build flags. Each engine can also select its layout explicitly.
+*/
+#pragma once
+#include <Arduino.h>
+#include "Compile_time_table.h"
+
+namespace Crc16
+{
+  enum class Table_Size
+  {
+    Nibble,
+    Byte,
+    Slice_By_4,
+  };
+
+#if defined(CRC16_TABLE_NIBBLE)
+  constexpr Table_Size DEFAULT_TABLE_SIZE = Table_Size::Nibble;
+#elif defined(CRC16_TABLE_SLICE_BY_4)
+  constexpr Table_Size DEFAULT_TABLE_SIZE = Table_Size::Slice_By_4;
+#else
+  constexpr Table_Size DEFAULT_TABLE_SIZE = Table_Size::Byte;
+#endif
+
+  /**
+   * @brief Bit by bit CRC calculation of a single value. Only used to generate the lookup tables
+   * @param crc Value to shift through the polynomial (already aligned to the correct end of the register)
+   * @param polynomial CRC polynomial (bit reversed if reflected)
+   * @param reflected True if the CRC is calculated LSB first
+   * @param bits Number of bits to process
+   * @return CRC register after processing the bits
+   */
+  constexpr uint16_t calculate_bitwise(uint16_t crc, uint16_t polynomial, bool reflected, uint8_t bits)
+  {
+    // Single return statement so it stays a valid C++11 constexpr function
+    return bits == 0 ? crc
+                     : calculate_bitwise(reflected ? ((crc & 0x0001) ? (crc >> 1) ^ polynomial : crc >> 1)
+                                                   : ((crc & 0x8000) ? static_cast<uint16_t>(crc << 1) ^ polynomial : static_cast<uint16_t>(crc << 1)),
+                                         polynomial, reflected, bits - 1);
+  }
+
+  // Lookup tables with N rows of 256 entries. Row 0 is the normal byte table,
+  // row k is the CRC of a byte followed by k zero bytes (used by slice-by-N)
+  template <uint16_t Polynomial, bool Reflected, uint8_t Rows>
+  struct Byte_Table
+  {
+    uint16_t entries[Rows][256];
+
+    static constexpr uint16_t calculate_entry(uint8_t row, uint16_t index)
+    {
+      return row == 0 ? (Reflected ? calculate_bitwise(index, Polynomial, true, 8) : calculate_bitwise(index << 8, Polynomial, false, 8))
+                      : shift_zero_byte(calculate_entry(row - 1, index));
+    }
+
+    // Process one more zero byte after the value of the previous row
+    static constexpr uint16_t shift_zero_byte(uint16_t previous)
+    {
+      return Reflected ? (previous >> 8) ^ calculate_entry(0, previous & 0xFF) : static_cast<uint16_t>(previous << 8) ^ calculate_entry(0, previous >> 8);
+    }
+
+    constexpr Byte_Table() : Byte_Table(typename Compile_Time_Table::Make_Index_List<Rows * 256>::type()) {}
+
+    template <uint16_t... Indices>
+    constexpr Byte_Table(Compile_Time_Table::Index_List<Indices...>) : entries{calculate_entry(Indices / 256, Indices % 256)...} {}
+  };
+
+  template <uint16_t Polynomial, bool Reflected>
+  struct Nibble_Table
+  {
+    uint16_t entries[16];
+
+    static constexpr uint16_t calculate_entry(uint8_t index)
+    {
+      return Reflected ? calculate_bitwise(index, Polynomial, true, 4) : calculate_bitwise(index << 12, Polynomial, false, 4);
+    }
+
+    constexpr Nibble_Table() : Nibble_Table(typename Compile_Time_Table::Make_Index_List<16>::type()) {}
+
+    template <uint16_t... Indices>
+    constexpr Nibble_Table(Compile_Time_Table::Index_List<Indices...>) : entries{calculate_entry(Indices)...} {}
+  };
+
+  // Table layout specific update functions
+  template <uint16_t Polynomial, bool Reflected, Table_Size Size>
+  struct Table_Update;
+
+  template <uint16_t Polynomial, bool Reflected>
+  struct Table_Update<Polynomial, Reflected, Table_Size::Nibble>
+  {
+    static constexpr Nibble_Table<Polynomial, Reflected> table{};
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, size_t length)
+    {
+      for (size_t i = 0; i < length; i++)
+      {
+        if (Reflected)
+        {
+          crc ^= data[i];
+          crc = (crc >> 4) ^ table.entries[crc & 0x0F];
+          crc = (crc >> 4) ^ table.entries[crc & 0x0F];
+        }
+        else
+        {
+          crc ^= static_cast<uint16_t>(data[i]) << 8;
+          crc = static_cast<uint16_t>(crc << 4) ^ table.entries[crc >> 12];
+          crc = static_cast<uint16_t>(crc << 4) ^ table.entries[crc >> 12];
+        }
+      }
+      return crc;
+    }
+  };
+
+  template <uint16_t Polynomial, bool Reflected>
+  struct Table_Update<Polynomial, Reflected, Table_Size::Byte>
+  {
+    static constexpr Byte_Table<Polynomial, Reflected, 1> table{};
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, size_t length)
+    {
+      for (size_t i = 0; i < length; i++)
+      {
+        if (Reflected)
+        {
+          crc = (crc >> 8) ^ table.entries[0][(crc ^ data[i]) & 0xFF];
+        }
+        else
+        {
+          crc = static_cast<uint16_t>(crc << 8) ^ table.entries[0][((crc >> 8) ^ data[i]) & 0xFF];
+        }
+      }
+      return crc;
+    }
+  };
+
+  template <uint16_t Polynomial, bool Reflected>
+  struct Table_Update<Polynomial, Reflected, Table_Size::Slice_By_4>
+  {
+    static constexpr Byte_Table<Polynomial, Reflected, 4> table{};
+
+    static uint16_t update(uint16_t crc, const uint8_t *data, size_t length)
+    {
+      // Process 4 bytes at a time. The 16-bit register is fully shifted out after the first 2 bytes,
+      // so the last 2 bytes only need their own table lookups
+      while (length >= 4)
+      {
+        if (Reflected)
+        {
+          crc ^= data[0] | (static_cast<uint16_t>(data[1]) << 8);
+          crc = table.entries[3][crc & 0xFF] ^ table.entries[2][crc >> 8] ^ table.entries[1][data[2]] ^ table.entries[0][data[3]];
+        }
+        else
+        {
+          crc ^= (static_cast<uint16_t>(data[0]) << 8) | data[1];
+          crc = table.entries[3][crc >> 8] ^ table.entries[2][crc & 0xFF] ^ table.entries[1][data[2]] ^ table.entries[0][data[3]];
+        }
+        data += 4;
+        length -= 4;
+      }
+      // Process the remaining bytes one at a time
+      return Table_Update<Polynomial, Reflected, Table_Size::Byte>::update(crc, data, length);
+    }
+  };
+
+  template <uint16_t Polynomial, bool Reflected>
+  constexpr Nibble_Table<Polynomial, Reflected> Table_Update<Polynomial, Reflected, Table_Size::Nibble>::table;
+  template <uint16_t Polynomial, bool Reflected>
+  constexpr Byte_Table<Polynomial, Reflected, 1> Table_Update<Polynomial, Reflected, Table_Size::Byte>::table;
+  template <uint16_t Polynomial, bool Reflected>
+  constexpr Byte_Table<Polynomial, Reflected, 4> Table_Update<Polynomial, Reflected, Table_Size::Slice_By_4>::table;
+
+  /**
+   * @brief CRC-16 engine
+   * @tparam Polynomial CRC polynomial (bit reversed if reflected)
+   * @tparam Initial_Value Value of the CRC register before any data is processed
+   * @tparam Reflected True if the CRC is calculated LSB first
+   * @tparam Size Lookup table layout
+   */
+  template <uint16_t Polynomial, uint16_t Initial_Value, bool Reflected, Table_Size Size = DEFAULT_TABLE_SIZE>
+  class Engine
+  {
+  public:
+    /**
+     * @brief Get the starting state for an incremental calculation
+     * @return Initial CRC register value
+     */
+    static constexpr uint16_t init() { return Initial_Value; }
+
+    /**
+     * @brief Continue a CRC calculation with more data
+     * @param state CRC state returned by init() or a previous update()
+     * @param data Pointer to data byte array
+     * @param length Length of data
+     * @return New CRC state. After the last update this is the checksum
+     */
+    static uint16_t update(uint16_t state, const uint8_t *data, size_t length) { return Table_Update<Polynomial, Reflected, Size>::update(state, data, length); }
+
+    /**
+     * @brief Calculate the checksum of a whole byte array
+     * @param data Pointer to data byte array
+     * @param length Length of data
+     * @return CRC-16 checksum
+     */
+    static uint16_t calculate(const uint8_t *data, size_t length) { return update(init(), data, length); }
+  };
+
+  // CRC used for CCSDS packets (polynomial 0x1021 reflected, initial value 0xFFFF)
+  template <Table_Size Size = DEFAULT_TABLE_SIZE>
+  using Ccitt_Reflected = Engine<0x8408, 0xFFFF, true, Size>;
+
+  // CRC used for RadioLib wrapper text checksums (polynomial 0x1021, initial value 0xFFFF)
+  template <Table_Size Size = DEFAULT_TABLE_SIZE>
+  using Ccitt = Engine<0x1021, 0xFFFF, false, Size>;
+}
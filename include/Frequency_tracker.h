@@ -0,0 +1,82 @@
+#pragma once
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include <Arduino.h>
+
+/*
+  Tracks the carrier frequency of the other side from the frequency error of received packets.
+
+  Every packet gives a noisy measurement of the carrier offset from the configured centre frequency.
+  An alpha-beta filter smooths the offset and estimates its drift rate (for example thermal drift of
+  modules without a TCXO), so the receiver follows the carrier without jumping after one bad estimate:
+    - Packets with SNR below min_snr are ignored, their frequency error estimate is unreliable
+    - The receiver frequency moves at most max_step per packet
+    - The offset is limited to max_offset from the centre frequency
+  With beta = 0 the filter is a plain exponentially weighted moving average.
+*/
+class Frequency_Tracker
+{
+public:
+  struct Config
+  {
+    float alpha;       // Offset gain (0 to 1). Lower is smoother, but follows slower
+    float beta;        // Drift rate gain (0 to 1, usually much lower than alpha). 0 disables drift tracking
+    float min_snr;     // Packets with lower SNR are not used (dB)
+    double max_step;   // Largest change of the receiver frequency per packet (MHz)
+    double max_offset; // Largest allowed offset from the centre frequency (MHz)
+  };
+
+  // Filter state, for telemetry
+  struct State
+  {
+    double offset;          // Filtered carrier offset from the centre frequency (MHz)
+    double drift;           // Filtered drift rate of the offset (MHz/s)
+    double frequency;       // Frequency the receiver is tuned to (MHz)
+    float last_error;       // Last measured frequency error (Hz)
+    uint32_t accepted;      // Measurements used by the filter
+    uint32_t rejected;      // Measurements ignored because of low SNR
+    uint32_t limited;       // Updates where the step or offset had to be limited
+  };
+
+  static const Config DEFAULT_CONFIG;
+
+private:
+  Config _config;
+  double _centre_frequency;
+  State _state;
+  bool _has_measurement;
+  uint32_t _last_update_time;
+
+public:
+  /**
+   * @brief Create a new tracker
+   * @param config Filter configuration
+   * @param centre_frequency Configured frequency in MHz
+   */
+  Frequency_Tracker(const Config &config = DEFAULT_CONFIG, double centre_frequency = 0);
+
+  /**
+   * @brief Forget the filter state and start from the centre frequency
+   * @param centre_frequency Configured frequency in MHz
+   */
+  void reset(double centre_frequency);
+
+  /**
+   * @brief Add the measurement of a received packet
+   * @param frequency_error Frequency error reported by the radio in Hz (positive if the carrier is below the receiver frequency)
+   * @param snr SNR of the packet in dB
+   * @param now Current time in ms
+   * @return Frequency the receiver should be tuned to in MHz
+   */
+  double update(double frequency_error, float snr, uint32_t now = millis());
+
+  /**
+   * @brief Undo the last frequency change, because the radio failed to tune to it
+   * @param frequency Frequency the radio is still tuned to in MHz
+   */
+  void set_tuned_frequency(double frequency) { _state.frequency = frequency; }
+
+  double get_frequency() const { return _state.frequency; }
+  const State &get_state() const { return _state; }
+};
+
+#endif // RADIOLIB_WRAPPER_ENABLE
@@ -4,57 +4,119 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include "Sensor_wrapper.h"
+#include "Crc16.h"
+#include "Radio_interrupts.h"
+#include "Frequency_tracker.h"
+#include "Radio_time_on_air.h"
+#ifdef SIMULATED_RADIO_ENABLE
+#include "Simulated_radio.h"
+#endif
 
-namespace RadioLib_interrupts
-{
-    /**
-     * @brief Set the flag that a action has finished
-     */
-    void set_action_done_flag(void);
-}
+// Number of frames that can wait in the transmit queue. 0 disables the queue, so no memory is reserved for it
+#ifndef RADIOLIB_WRAPPER_TX_QUEUE_LENGTH
+#define RADIOLIB_WRAPPER_TX_QUEUE_LENGTH 0
+#endif
+
+// Longest frame that can be queued (LoRa max payload length)
+#ifndef RADIOLIB_WRAPPER_TX_QUEUE_FRAME_LENGTH
+#define RADIOLIB_WRAPPER_TX_QUEUE_FRAME_LENGTH 255
+#endif
+
+// Number of received frames that can wait in the receive ring. 0 disables receive buffering, so no memory is reserved for it
+#ifndef RADIOLIB_WRAPPER_RX_RING_LENGTH
+#define RADIOLIB_WRAPPER_RX_RING_LENGTH 0
+#endif
+
+// Longest frame that can be stored in the receive ring (LoRa max payload length)
+#ifndef RADIOLIB_WRAPPER_RX_RING_FRAME_LENGTH
+#define RADIOLIB_WRAPPER_RX_RING_FRAME_LENGTH 255
+#endif
+
+// Extra time allowed for a transmission on top of 1.5 x its expected time on air before the radio is considered stuck (ms)
+#ifndef RADIOLIB_WRAPPER_TX_TIMEOUT_MARGIN
+#define RADIOLIB_WRAPPER_TX_TIMEOUT_MARGIN 100
+#endif
+
+// By default the checksum skips the first 2 characters of any message starting with '$', the original wire format.
+// Set to 0 to only skip a "$$" prefix, so a single '$' is checksummed too. Every radio on the link must use the same setting
+#ifndef RADIOLIB_WRAPPER_LEGACY_CHECKSUM_PREFIX
+#define RADIOLIB_WRAPPER_LEGACY_CHECKSUM_PREFIX 1
+#endif
+
+// Number of buckets in each link quality histogram
+#ifndef RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS
+#define RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS 16
+#endif
+
+// Histogram bucket ranges. Values outside the range are counted in the first or last bucket
+const float RADIOLIB_WRAPPER_RSSI_HISTOGRAM_START = -140;           // dBm
+const float RADIOLIB_WRAPPER_RSSI_HISTOGRAM_WIDTH = 8;              // dBm
+const float RADIOLIB_WRAPPER_SNR_HISTOGRAM_START = -20;             // dB
+const float RADIOLIB_WRAPPER_SNR_HISTOGRAM_WIDTH = 2.5;             // dB
+const float RADIOLIB_WRAPPER_FREQUENCY_ERROR_HISTOGRAM_START = -8000; // Hz
+const float RADIOLIB_WRAPPER_FREQUENCY_ERROR_HISTOGRAM_WIDTH = 1000;  // Hz
 
-// TODO: Implement timeouts for interrupts
 template <typename T>
 class RadioLib_Wrapper : public Sensor_Wrapper
 {
-private:
-    bool _frequency_correction_enabled;
-    double _used_frequency; // Current frequency used if frequency correction enabled
-    int _action_status_code;
+public:
+    // How the checksum is added to the end of a message
+    enum Checksum_Format
+    {
+        Hex,   // "*" + checksum as hex text + "\n", up to 6 extra bytes
+        Binary // 2 checksum bytes, MSB first
+    };
 
-    // Usually displays the last action the radio did
-    enum Action_Type
+    // Transmit queue priority. Higher priority frames are sent first
+    enum Transmit_Priority
     {
-        Transmit,
-        Receive,
-        Standby,
+        Low,    // Bulk data, dropped first when the queue is full
+        Normal, // Routine telemetry
+        High    // Telecommand responses
     };
-    Action_Type _action_type;
-    //used for crc
-    uint16_t crc_xmodem_update(uint16_t crc, uint8_t data);
-    /**
-     * @brief Configure sx126x based radios so that the chip uses DIO2 pin to control the RXEN and TXEN pins
-     *
-     * @return true Behaviour set
-     * @return false Failed to set behaviour
-     */
-    bool configure_tx_rx_switching();
 
-    /**
-     * @brief Configure sx126x based radios so that micro controller controls the RXEN and TXEN pins
-     *
-     * @param rx_enable RX enable pin
-     * @param tx_enable TX enable pin
-     * @return true Behaviour set
-     * @return false Failed to set behaviour
-     */
-    bool configure_tx_rx_switching(int rx_enable, int tx_enable);
+    struct Tx_Queue_Statistics
+    {
+        uint32_t queued;      // Frames added to the queue
+        uint32_t transmitted; // Queued frames that were started
+        uint32_t failed;      // Queued frames the radio failed to start
+        uint32_t overflows;   // Frames rejected because the queue was full
+        uint32_t evicted;     // Lower priority frames dropped to make space for higher priority ones
+    };
 
-    bool setBoostedRx();
+    // Reception details of a frame in the receive ring
+    struct Rx_Metadata
+    {
+        float rssi;             // dBm
+        float snr;              // dB
+        double frequency_error; // Hz
+        double frequency;       // Frequency the frame was received on in MHz
+        uint32_t timestamp;     // millis() when the receive interrupt fired
+    };
 
-    uint16_t calculate_CRC16_CCITT_checksum(const String &msg);
+    struct Rx_Ring_Statistics
+    {
+        uint32_t received;  // Frames stored in the ring
+        uint32_t overflows; // Frames dropped because the ring was full
+        uint32_t errors;    // Frames that failed to be read, for example CRC errors
+    };
+
+    // Radio link counters and link quality histograms
+    struct Radio_Statistics
+    {
+        uint32_t transmitted;          // Transmissions started
+        uint32_t transmit_failures;    // Transmissions the radio failed to start
+        uint32_t received;             // Frames read successfully
+        uint32_t receive_failures;     // Frames that failed to be read, for example CRC errors
+        uint32_t timeouts;             // Missed transmit done interrupts
+        uint32_t transmit_time_on_air; // Total transmit time with the modulation used for each frame (ms)
+        uint32_t receive_time_on_air;  // Total time of received frames (ms)
+        uint32_t start_time;           // millis() when counting started
+        uint32_t rssi_histogram[RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS];
+        uint32_t snr_histogram[RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS];
+        uint32_t frequency_error_histogram[RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS];
+    };
 
-public:
     // Config file
     struct Radio_Config
     {
@@ -91,7 +153,173 @@ public:
         bool frequency_correction;
 
         SPIClass *spi_bus; // Example &SPI
+
+        bool reconfigure_on_timeout; // Run configure_radio again when recovering from a missed interrupt. Defaults to false when omitted
+
+        Frequency_Tracker::Config frequency_tracking; // Filtering of the frequency correction. Frequency_Tracker::DEFAULT_CONFIG is used when omitted (alpha == 0)
     };
+
+private:
+    bool _frequency_correction_enabled;
+    double _used_frequency; // Current frequency used if frequency correction enabled
+    int _action_status_code;
+
+    // Usually displays the last action the radio did
+    enum Action_Type
+    {
+        Transmit,
+        Receive,
+        Standby,
+    };
+    Action_Type _action_type;
+
+    // Set by this radio's interrupt when the current action has finished
+    RadioLib_interrupts::Action_Flag _action_flag;
+    int8_t _interrupt_slot = -1;
+
+#if RADIOLIB_WRAPPER_TX_QUEUE_LENGTH > 0
+    // Pre-allocated transmit queue slot
+    struct Tx_Queue_Slot
+    {
+        uint8_t data[RADIOLIB_WRAPPER_TX_QUEUE_FRAME_LENGTH];
+        uint16_t length;
+        uint8_t priority;
+        uint32_t order; // Frames with the same priority are sent in the order they were queued
+        bool used;
+    };
+    Tx_Queue_Slot _tx_queue[RADIOLIB_WRAPPER_TX_QUEUE_LENGTH];
+    uint32_t _tx_queue_order = 0;
+
+    /**
+     * @brief Find the queued frame that should be sent next
+     *
+     * @return int Index of the frame or -1 if the queue is empty
+     */
+    int get_next_tx_queue_index();
+#endif
+    uint8_t _tx_queue_count = 0;
+    Tx_Queue_Statistics _tx_queue_statistics = {};
+
+    bool _rx_buffering_enabled = false;
+
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH > 0
+    // Receive ring, frames [_rx_ring_head, _rx_ring_head + _rx_ring_count) are waiting to be read
+    struct Rx_Ring_Slot
+    {
+        uint8_t data[RADIOLIB_WRAPPER_RX_RING_FRAME_LENGTH];
+        uint16_t length;
+        Rx_Metadata metadata;
+    };
+    Rx_Ring_Slot _rx_ring[RADIOLIB_WRAPPER_RX_RING_LENGTH];
+    uint8_t _rx_ring_head = 0;
+
+    /**
+     * @brief Read the frame waiting in the radio into the receive ring and start receiving again
+     */
+    void service_rx_ring();
+#endif
+    uint8_t _rx_ring_count = 0;
+    Rx_Ring_Statistics _rx_ring_statistics = {};
+
+    /**
+     * @brief Start receiving the next frame
+     *
+     * @return true If receive was started
+     * @return false If receive failed to start
+     */
+    bool restart_receive();
+
+    // Modulation currently set in the radio
+    struct Modulation
+    {
+        int spreading;
+        float signal_bw;
+        int coding_rate;
+        Radio_Time_On_Air::Chip_Family family;
+    };
+    Modulation _modulation = {};
+
+    uint32_t _action_start_time = 0;
+    uint32_t _action_timeout = 0; // 0 if the current action can't time out
+    Radio_Config *_radio_config = nullptr; // Copy of the config given to begin(), used to reconfigure after a timeout
+
+    Radio_Statistics _statistics = {};
+    volatile uint32_t _statistics_sequence = 0; // Odd while the statistics are being updated
+
+    /**
+     * @brief Update the statistics and start the watchdog after a transmission was started
+     *
+     * @param length Number of bytes being transmitted
+     * @param success True if the transmission started
+     */
+    void record_transmit(size_t length, bool success);
+
+    /**
+     * @brief Update the statistics after a frame was read from the radio
+     *
+     * @param length Frame length, 0 if reading failed
+     * @param rssi RSSI of the frame in dBm
+     * @param snr SNR of the frame in dB
+     * @param frequency_error Frequency error of the frame in Hz
+     */
+    void record_receive(size_t length, float rssi, float snr, float frequency_error);
+
+    /**
+     * @brief Mark the start and end of a statistics update, so get_statistics() can detect a torn copy
+     */
+    void begin_statistics_update();
+    void end_statistics_update();
+
+    /**
+     * @brief Recover the radio if the current transmission took much longer than its time on air, because the interrupt was missed
+     *
+     * @return true If the radio was stuck and has been recovered
+     * @return false If nothing has timed out
+     */
+    bool check_action_timeout();
+
+    // Filters the frequency error of received frames if frequency correction is enabled
+    Frequency_Tracker _frequency_tracker;
+
+    /**
+     * @brief Move the used frequency to compensate for the measured frequency error
+     *
+     * @param frequency_error Frequency error of the last received frame in Hz
+     * @param snr SNR of the last received frame in dB
+     * @return double Frequency used from now on in MHz
+     */
+    double correct_frequency(double frequency_error, float snr);
+
+    /**
+     * @brief Configure sx126x based radios so that the chip uses DIO2 pin to control the RXEN and TXEN pins
+     *
+     * @return true Behaviour set
+     * @return false Failed to set behaviour
+     */
+    bool configure_tx_rx_switching();
+
+    /**
+     * @brief Configure sx126x based radios so that micro controller controls the RXEN and TXEN pins
+     *
+     * @param rx_enable RX enable pin
+     * @param tx_enable TX enable pin
+     * @return true Behaviour set
+     * @return false Failed to set behaviour
+     */
+    bool configure_tx_rx_switching(int rx_enable, int tx_enable);
+
+    bool setBoostedRx();
+
+    uint16_t calculate_CRC16_CCITT_checksum(const String &msg);
+
+    uint16_t calculate_CRC16_CCITT_checksum(const char *msg, size_t length);
+
+    /**
+     * @brief Get the index where the checksummed part of a message starts. A "$$" prefix is not included in the checksum
+     */
+    size_t get_checksum_start(const char *msg, size_t length);
+
+public:
     // Radio object
     T radio = new Module(-1, -1, -1, -1);
 
@@ -102,6 +330,15 @@ public:
      */
     RadioLib_Wrapper(void (*error_function)(String) = nullptr, int check_sum_length = 5, String sensor_name = "RadioLib_Default");
 
+    /**
+     * @brief Frees the interrupt slot of the radio
+     */
+    ~RadioLib_Wrapper();
+
+    // The wrapper owns its interrupt slot and saved config, so it can't be copied
+    RadioLib_Wrapper(const RadioLib_Wrapper &) = delete;
+    RadioLib_Wrapper &operator=(const RadioLib_Wrapper &) = delete;
+
     /**
      * @brief
      *
@@ -120,12 +357,31 @@ public:
      */
     bool configure_radio(Radio_Config radio_config);
 
+    /**
+     * @brief Change the modulation without reconfiguring the rest of the radio. Used for adaptive data rate
+     *
+     * @param spreading Spreading factor
+     * @param signal_bw Signal bandwidth in kHz
+     * @param coding_rate Coding rate denominator (5 to 8)
+     * @return true If changed successfully
+     * @return false If the radio is busy transmitting or a value is invalid. Nothing is changed if a value is invalid
+     */
+    bool set_modulation(int spreading, float signal_bw, int coding_rate);
+
+    /**
+     * @brief Get how long a frame occupies the channel with the current modulation
+     *
+     * @param length Frame length in bytes
+     * @return uint32_t Time on air in microseconds
+     */
+    uint32_t get_time_on_air(size_t length) const;
+
     /**
      * @brief Send a message over the radio
      *
      * @param msg Message to send
      * @return true If transmit was successful
-     * @return false If transmit failed
+     * @return false If transmit failed or the radio is still transmitting. Use queue_transmit() to not lose the message
      */
     bool transmit(String msg);
 
@@ -135,10 +391,126 @@ public:
      * @param msg Bytes to send
      * @param length Byte array length
      * @return true If transmit was successful
-     * @return false If transmit failed
+     * @return false If transmit failed or the radio is still transmitting. Use queue_transmit_bytes() to not lose the bytes
      */
     bool transmit_bytes(uint8_t* bytes, size_t length);
 
+    /**
+     * @brief Add a frame to the transmit queue, so it isn't lost if the radio is busy. Call poll() to send it
+     * @note The queue is disabled by default, set RADIOLIB_WRAPPER_TX_QUEUE_LENGTH in the build flags to use it
+     *
+     * @param bytes Bytes to send
+     * @param length Byte array length, at most RADIOLIB_WRAPPER_TX_QUEUE_FRAME_LENGTH
+     * @param priority Transmit priority. If the queue is full, the newest frame with the lowest priority is dropped for a higher priority frame
+     * @return true If the frame was queued
+     * @return false If the queue is full or disabled, or the frame is too long
+     */
+    bool queue_transmit_bytes(const uint8_t *bytes, size_t length, Transmit_Priority priority = Transmit_Priority::Normal);
+
+    /**
+     * @brief Add a message to the transmit queue, so it isn't lost if the radio is busy. Call poll() to send it
+     *
+     * @param msg Message to send
+     * @param priority Transmit priority
+     * @return true If the message was queued
+     * @return false If the queue is full or disabled, or the message is too long
+     */
+    bool queue_transmit(const String &msg, Transmit_Priority priority = Transmit_Priority::Normal);
+
+    /**
+     * @brief Service the radio: move a received frame into the receive ring (if enabled) and start transmitting the next
+     * queued frame as soon as the previous transmission is done. Call this often in the loop, so the radio doesn't idle
+     * when there are queued frames and received frames are read out before the next one arrives
+     *
+     * @return true If a transmission was started
+     * @return false If the queue is empty or the radio is still transmitting
+     */
+    bool poll();
+
+    /**
+     * @brief Get number of frames waiting in the transmit queue
+     */
+    uint8_t get_tx_queue_count() const { return _tx_queue_count; }
+
+    /**
+     * @brief Get transmit queue counters
+     */
+    const Tx_Queue_Statistics &get_tx_queue_statistics() const { return _tx_queue_statistics; }
+
+    /**
+     * @brief Drop all queued frames
+     */
+    void clear_tx_queue();
+
+    /**
+     * @brief Start interrupt driven receiving. Every received frame is moved from the radio into the receive ring by poll(),
+     * so frames aren't lost while the loop is busy. Don't use receive() or receive_bytes() while this is enabled
+     * @note The receive ring is disabled by default, set RADIOLIB_WRAPPER_RX_RING_LENGTH in the build flags to use it
+     *
+     * @return true If receiving was started
+     * @return false If receiving failed to start or the receive ring is disabled
+     */
+    bool start_receive_buffering();
+
+    /**
+     * @brief Stop moving received frames into the receive ring. Frames already in the ring can still be read
+     */
+    void stop_receive_buffering();
+
+    /**
+     * @brief Take the oldest frame out of the receive ring
+     *
+     * @param bytes Pointer to where to save the frame
+     * @param size Size of the bytes buffer. Longer frames are cut off
+     * @param data_length Reference to variable where to save the frame length
+     * @param metadata Reference to variable where to save the reception details
+     * @return true If a frame was read
+     * @return false If the receive ring is empty
+     */
+    bool read_received_bytes(uint8_t *bytes, uint16_t size, uint16_t &data_length, Rx_Metadata &metadata);
+
+    /**
+     * @brief Get the state of the frequency correction filter, for telemetry
+     */
+    const Frequency_Tracker::State &get_frequency_tracker_state() const { return _frequency_tracker.get_state(); }
+
+    /**
+     * @brief Get number of times the radio was recovered after a missed transmit done interrupt
+     */
+    uint32_t get_timeout_count() const { return _statistics.timeouts; }
+
+    /**
+     * @brief Get a consistent copy of the link statistics. Safe to call from another task or core without locking,
+     * the copy is retried if the statistics changed while copying
+     *
+     * @return Radio_Statistics Statistics copy
+     */
+    Radio_Statistics get_statistics() const;
+
+    /**
+     * @brief Get the fraction of time spent transmitting since the statistics were reset
+     *
+     * @param statistics Statistics copy from get_statistics()
+     * @param now Current time in ms
+     * @return float Transmit duty cycle (0 to 1)
+     */
+    static float get_transmit_duty_cycle(const Radio_Statistics &statistics, uint32_t now = millis());
+
+    /**
+     * @brief Set all statistics to zero and start counting time from now
+     */
+    void reset_statistics();
+
+    /**
+     * @brief Get number of frames waiting in the receive ring
+     */
+    uint8_t get_rx_ring_count() const { return _rx_ring_count; }
+
+    /**
+     * @brief Get receive ring counters
+     */
+    const Rx_Ring_Statistics &get_rx_ring_statistics() const { return _rx_ring_statistics; }
+
     /**
      * @brief Read any received data
      *
@@ -176,6 +548,41 @@ public:
      */
     bool check_checksum(String &msg);
 
+    /**
+     * @brief Add the checksum to the end of a message in place, without any heap allocations
+     *
+     * @param msg Message buffer
+     * @param length Message length
+     * @param size Size of the message buffer. Hex format needs up to 7 free bytes (the text is also null terminated), binary format 2
+     * @param format Checksum format
+     * @return size_t New message length or 0 if the checksum doesn't fit in the buffer
+     */
+    size_t add_checksum(char *msg, size_t length, size_t size, Checksum_Format format = Checksum_Format::Hex);
+
+    /**
+     * @brief Find and verify the checksum of a message without modifying it
+     *
+     * @param msg Received message
+     * @param length Received message length
+     * @param content_start Reference to variable where to save the index of the message content
+     * @param content_length Reference to variable where to save the length of the message content
+     * @param format Checksum format
+     * @return true The checksum is correct
+     * @return false The checksum is missing or wrong
+     */
+    bool verify_checksum(const char *msg, size_t length, size_t &content_start, size_t &content_length, Checksum_Format format = Checksum_Format::Hex);
+
+    /**
+     * @brief Verify the checksum of a message and remove it in place, without any heap allocations
+     *
+     * @param msg Received message. If verified the content is moved to the start and null terminated
+     * @param length Received message length. If verified it is changed to the content length
+     * @param format Checksum format
+     * @return true The checksum is correct and was removed
+     * @return false The checksum is missing or wrong, msg is left as is
+     */
+    bool check_checksum(char *msg, size_t &length, Checksum_Format format = Checksum_Format::Hex);
+
     /**
      * @brief Set the error output function object. If not set by default error will be output in serial port.
      * Note that if the function is inside a class then passing it to the set error output might be difficult
@@ -206,6 +613,11 @@ template class RadioLib_Wrapper<SX1280>;
 template class RadioLib_Wrapper<SX1281>;
 template class RadioLib_Wrapper<SX1282>;
 
+// Simulated radio for host tests
+#ifdef SIMULATED_RADIO_ENABLE
+template class RadioLib_Wrapper<Simulated_Radio>;
+#endif
+
 // Selected RFM9x LoRa types
 // template class RadioLib_Wrapper<RFM95>;
 // template class RadioLib_Wrapper<RFM96>;
@@ -0,0 +1,210 @@
+#pragma once
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include <Arduino.h>
+
+/*
+  Adaptive data rate for LoRa links.
+
+  The controller keeps a moving window of the SNR and RSSI of received frames and picks the fastest modulation
+  step (spreading factor, bandwidth, coding rate) that still leaves the configured link margin above the
+  demodulation floor of that step. Faster steps are only used if the margin is exceeded by the
+  hysteresis too, so the link doesn't toggle between two steps. Only the SNR decides, because it sets the
+  demodulation limit of LoRa. The RSSI average is kept for telemetry.
+
+  Both ends must change the modulation at the same time, so one side (the initiator, usually the ground
+  station) decides and asks the other side with a small handshake:
+    initiator -> responder  REQUEST(step, change id)
+    responder -> initiator  ACK(step, change id, responder SNR)   responder switches after the ACK is sent
+    initiator switches when the ACK is received. If no ACK arrives after max_requests requests, the initiator
+    switches anyway, because the responder most likely switched and only the ACK was lost.
+  The responder also reports its SNR every hold_time while its window is full:
+    responder -> initiator  REPORT(step, change id, responder SNR)
+  The initiator ignores a responder SNR older than 2 x hold_time, so lost reports can't keep the link slow.
+  If nothing is received for fallback_timeout, both sides independently fall back to the most robust step,
+  so the link always recovers.
+
+  Frame format:
+    byte 0 - RADIO_ADAPTIVE_RATE_FRAME_MARKER | frame type
+    byte 1 - step index
+    byte 2 - change id
+    byte 3 - ACK and REPORT only: average SNR of the responder in 0.25 dB units (int8)
+
+  Example (in the loop):
+    if (radio.receive_bytes(frame, length, rssi, snr, frequency))
+    {
+      rate.add_sample(snr, rssi);
+      if (!rate.receive(frame, length)) { handle other frames }
+    }
+    length = rate.build_frame(frame, sizeof(frame));
+    if (length != 0 && radio.transmit_bytes(frame, length)) rate.mark_frame_sent();
+    rate.apply(radio);
+*/
+
+// Number of SNR and RSSI samples in the moving window
+#ifndef RADIO_ADAPTIVE_RATE_WINDOW
+#define RADIO_ADAPTIVE_RATE_WINDOW 8
+#endif
+
+const uint8_t RADIO_ADAPTIVE_RATE_FRAME_MARKER = 0xB0;
+const uint8_t RADIO_ADAPTIVE_RATE_FRAME_MARKER_MASK = 0xF0;
+const uint8_t RADIO_ADAPTIVE_RATE_REQUEST = 0x01;
+const uint8_t RADIO_ADAPTIVE_RATE_ACK = 0x02;
+const uint8_t RADIO_ADAPTIVE_RATE_REPORT = 0x03;
+const uint8_t RADIO_ADAPTIVE_RATE_MAX_FRAME_LENGTH = 4;
+
+class Radio_Adaptive_Rate
+{
+public:
+  // One modulation setting
+  struct Step
+  {
+    uint8_t spreading;
+    float signal_bw;     // kHz
+    uint8_t coding_rate; // Denominator (5 to 8)
+    float required_snr;  // Demodulation floor of this setting in dB
+  };
+
+  struct Config
+  {
+    const Step *steps;        // Ordered from the fastest to the most robust
+    uint8_t step_count;
+    float link_margin;        // Required SNR above the demodulation floor (dB)
+    float hysteresis;         // Extra margin needed before switching to a faster step (dB)
+    uint32_t hold_time;       // Minimum time between switches (ms)
+    uint32_t fallback_timeout; // Fall back to the most robust step if nothing is received for this long (ms)
+    uint32_t request_timeout; // Time to wait for the ACK before the request is sent again (ms)
+    uint8_t max_requests;     // Requests sent before switching without an ACK
+    bool initiator;           // True on the side that decides, false on the side that follows
+  };
+
+  struct Statistics
+  {
+    uint32_t faster_switches; // Switches to a faster step
+    uint32_t slower_switches; // Switches to a more robust step
+    uint32_t fallbacks;       // Switches to the most robust step after the link was lost
+    uint32_t requests_sent;
+    uint32_t unacknowledged;  // Switches done without receiving the ACK
+    uint32_t reports_sent;    // Responder: SNR reports sent outside of the handshake
+  };
+
+  // Spreading factors 7 to 12 at 125 kHz with coding rate 4/5 and their SX127x/SX126x demodulation floors
+  static const Step DEFAULT_STEPS[];
+  static const uint8_t DEFAULT_STEP_COUNT;
+
+private:
+  Config _config;
+  Statistics _statistics;
+
+  uint8_t _step_index;         // Step currently used
+  uint8_t _applied_step_index; // Step last set in the radio
+
+  // SNR and RSSI moving window
+  float _snr_samples[RADIO_ADAPTIVE_RATE_WINDOW];
+  float _rssi_samples[RADIO_ADAPTIVE_RATE_WINDOW];
+  uint8_t _sample_count;
+  uint8_t _sample_index;
+  uint32_t _last_sample_time;
+  uint32_t _last_switch_time;
+
+  // Average SNR reported by the responder in the last ACK or REPORT
+  float _remote_snr;
+  bool _has_remote_snr;
+  uint32_t _remote_snr_time;
+  uint32_t _report_time;       // Responder: time of the last ACK or REPORT
+
+  // Handshake state
+  bool _request_active;        // Initiator: waiting for an ACK
+  uint8_t _requested_step;
+  uint8_t _change_id;
+  uint8_t _request_count;
+  uint32_t _request_time;
+  bool _ack_pending;           // Responder: ACK needs to be sent
+  bool _switch_after_ack;      // Responder: switch once the ACK has been sent
+
+  // Frame selected by build_frame(), committed by mark_frame_sent()
+  uint8_t _built_frame_type;
+
+  void switch_step(uint8_t step_index, uint32_t now);
+  void clear_samples();
+  bool choose_step(uint8_t &step_index, uint32_t now);
+  float get_average(const float *samples) const;
+  uint16_t encode_snr_frame(uint8_t *frame, uint8_t type);
+
+public:
+  /**
+   * @brief Create a new adaptive data rate controller
+   * @param config Controller configuration. The steps array must stay valid
+   * @param initial_step Step both sides use at startup, usually the most robust one (step_count - 1)
+   */
+  Radio_Adaptive_Rate(const Config &config, uint8_t initial_step);
+
+  /**
+   * @brief Add the signal quality of a received frame to the moving window
+   * @param snr SNR of the frame in dB
+   * @param rssi RSSI of the frame in dBm
+   * @param now Current time in ms
+   */
+  void add_sample(float snr, float rssi, uint32_t now = millis());
+
+  /**
+   * @brief Process a received frame
+   * @param frame Pointer to received bytes
+   * @param length Number of received bytes
+   * @param now Current time in ms
+   * @return True if this was an adaptive rate frame, false if it should be handled elsewhere
+   */
+  bool receive(const uint8_t *frame, uint16_t length, uint32_t now = millis());
+
+  /**
+   * @brief Decide if the step should change and build the handshake frame to transmit, if any
+   * @param frame Pointer to at least RADIO_ADAPTIVE_RATE_MAX_FRAME_LENGTH bytes
+   * @param frame_size Size of the frame buffer
+   * @param now Current time in ms
+   * @return Frame length or 0 if nothing needs to be sent. Call mark_frame_sent() once the frame was actually transmitted
+   */
+  uint16_t build_frame(uint8_t *frame, uint16_t frame_size, uint32_t now = millis());
+
+  /**
+   * @brief Confirm that the last frame from build_frame() was transmitted
+   * @param now Current time in ms
+   */
+  void mark_frame_sent(uint32_t now = millis());
+
+  /**
+   * @brief Set the current step in the radio if it has changed
+   * @tparam Radio Anything with set_modulation() like RadioLib_Wrapper
+   * @param radio Radio to configure
+   * @return True if the radio uses the current step, false if it is busy and apply() needs to be called again
+   */
+  template <typename Radio>
+  bool apply(Radio &radio)
+  {
+    if (_applied_step_index == _step_index)
+    {
+      return true;
+    }
+    const Step &step = _config.steps[_step_index];
+    if (!radio.set_modulation(step.spreading, step.signal_bw, step.coding_rate))
+    {
+      return false;
+    }
+    _applied_step_index = _step_index;
+    return true;
+  }
+
+  /**
+   * @brief Get the average SNR of the moving window in dB. Only valid if there are samples
+   */
+  float get_average_snr() const { return get_average(_snr_samples); }
+
+  /**
+   * @brief Get the average RSSI of the moving window in dBm. Only valid if there are samples
+   */
+  float get_average_rssi() const { return get_average(_rssi_samples); }
+
+  uint8_t get_step_index() const { return _step_index; }
+  const Step &get_step() const { return _config.steps[_step_index]; }
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // RADIOLIB_WRAPPER_ENABLE
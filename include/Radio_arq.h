@@ -0,0 +1,244 @@
+#pragma once
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include <Arduino.h>
+
+/*
+  Selective-repeat ARQ (automatic repeat request) for reliable delivery over the radio.
+
+  Every payload is sent in a sequence numbered frame. Up to RADIO_ARQ_WINDOW_SIZE frames can be
+  in flight at once, so bulk transfers don't wait for an acknowledgement after every frame.
+  The receiver acknowledges with the next expected sequence number and a bitmap of the frames
+  received after it, so only the missing frames are retransmitted. Acknowledgements are added to
+  every outgoing frame and can also be piggybacked on telemetry with write_ack().
+  The retransmit timeout follows the measured round-trip time (smoothed RTT + 4 x RTT variance).
+  Every ACK also carries the oldest sequence number the sender still retransmits. Frames given up after
+  max_retransmissions are behind it, so the receiver delivers what it has after the gap instead of waiting.
+  Until the receiver confirms this, the sender repeats it in standalone frames with the SKIP flag.
+
+  Frame format:
+    byte 0     - RADIO_ARQ_FRAME_MARKER | flags (RADIO_ARQ_FLAG_DATA, RADIO_ARQ_FLAG_ACK, RADIO_ARQ_FLAG_SKIP)
+    ACK flag   - oldest unfinished sent sequence number (1 byte), next expected sequence number (1 byte),
+                 bitmap of the following 32 frames (4 bytes, MSB first)
+    DATA flag  - sequence number (1 byte), payload
+  Integrity is left to the radio CRC.
+
+  Example:
+    Radio_Arq arq(config, received_data_function);
+    arq.send(data, length);
+    ...
+    arq.update(radio); // In the loop, radio is a RadioLib_Wrapper
+*/
+
+// Number of frames that can be in flight. Transmit and receive buffers use 2 x size x RADIO_ARQ_MAX_PAYLOAD_LENGTH bytes
+#ifndef RADIO_ARQ_WINDOW_SIZE
+#define RADIO_ARQ_WINDOW_SIZE 8
+#endif
+
+// Largest payload in a single frame. The default makes the longest frame fit in a 255 byte LoRa packet
+#ifndef RADIO_ARQ_MAX_PAYLOAD_LENGTH
+#define RADIO_ARQ_MAX_PAYLOAD_LENGTH 247
+#endif
+
+static_assert(RADIO_ARQ_WINDOW_SIZE >= 1 && RADIO_ARQ_WINDOW_SIZE <= 32, "RADIO_ARQ_WINDOW_SIZE must be between 1 and 32");
+
+const uint8_t RADIO_ARQ_FRAME_MARKER = 0xA0;
+const uint8_t RADIO_ARQ_FRAME_MARKER_MASK = 0xF0;
+const uint8_t RADIO_ARQ_FLAG_DATA = 0x01;
+const uint8_t RADIO_ARQ_FLAG_ACK = 0x02;
+const uint8_t RADIO_ARQ_FLAG_SKIP = 0x04; // Sender gave up frames and waits for an ACK confirming the receiver skipped them
+const uint8_t RADIO_ARQ_ACK_LENGTH = 1 + 1 + 1 + 4;
+const uint16_t RADIO_ARQ_MAX_FRAME_LENGTH = RADIO_ARQ_ACK_LENGTH + 1 + RADIO_ARQ_MAX_PAYLOAD_LENGTH;
+
+class Radio_Arq
+{
+public:
+  struct Config
+  {
+    uint32_t initial_retransmit_timeout; // Used until the first round-trip time is measured (ms)
+    uint32_t min_retransmit_timeout;     // ms
+    uint32_t max_retransmit_timeout;     // ms
+    uint8_t max_retransmissions;         // Frame is given up after this many retransmissions
+    uint32_t ack_delay;                  // Wait this long after the last received frame before sending a standalone ACK, so bursts are acknowledged at once (ms)
+  };
+
+  struct Statistics
+  {
+    uint32_t frames_sent;     // Data frames sent the first time
+    uint32_t retransmissions; // Data frames sent again
+    uint32_t acknowledged;    // Data frames confirmed by the other side
+    uint32_t failed;          // Data frames given up after max_retransmissions
+    uint32_t delivered;       // Received payloads passed to the receive function
+    uint32_t duplicates;      // Received data frames that were already received
+    uint32_t acks_sent;       // Standalone ACK frames, including the ones only telling the other side about given up frames
+    uint32_t skipped;         // Received sequence numbers skipped, because the other side gave them up
+  };
+
+  // Called with every received payload, in the order they were sent
+  typedef void (*Receive_Function)(const uint8_t *data, uint16_t length);
+
+private:
+  struct Transmit_Slot
+  {
+    uint8_t data[RADIO_ARQ_MAX_PAYLOAD_LENGTH];
+    uint16_t length;
+    uint32_t sent_time;        // Time of the last transmission
+    uint32_t send_order;       // Value of the transmission counter at the last transmission
+    uint8_t transmissions;     // 0 if not sent yet
+    bool acknowledged;
+    bool retransmit_now;       // A frame sent after this one was acknowledged, so this one was most likely lost
+  };
+
+  struct Receive_Slot
+  {
+    uint8_t data[RADIO_ARQ_MAX_PAYLOAD_LENGTH];
+    uint16_t length;
+    bool received;
+  };
+
+  // Frame selected by build_frame(), committed by mark_frame_sent()
+  enum class Frame_Kind
+  {
+    None,
+    Data,
+    Ack,
+  };
+
+  Config _config;
+  Receive_Function _receive_function;
+  Statistics _statistics;
+
+  // Transmit side, sequence numbers [_send_base, _send_next) are in the window
+  Transmit_Slot _transmit_slots[RADIO_ARQ_WINDOW_SIZE];
+  uint8_t _send_base;
+  uint8_t _send_next;
+  uint32_t _send_counter;
+
+  // Frames were given up and the other side hasn't confirmed skipping them yet
+  bool _skip_pending;
+  uint8_t _skip_transmissions;
+  uint32_t _skip_sent_time;
+
+  // Receive side
+  Receive_Slot _receive_slots[RADIO_ARQ_WINDOW_SIZE];
+  uint8_t _receive_base; // Next expected sequence number
+  bool _ack_pending;
+  uint32_t _last_receive_time;
+
+  // Round-trip time estimate (ms)
+  bool _has_rtt_sample;
+  uint32_t _smoothed_rtt;
+  uint32_t _rtt_variance;
+  uint32_t _retransmit_timeout;
+
+  Frame_Kind _built_frame;
+  uint8_t _built_sequence;
+
+  Transmit_Slot &get_transmit_slot(uint8_t sequence) { return _transmit_slots[sequence % RADIO_ARQ_WINDOW_SIZE]; }
+  Receive_Slot &get_receive_slot(uint8_t sequence) { return _receive_slots[sequence % RADIO_ARQ_WINDOW_SIZE]; }
+  uint8_t get_in_flight_count() const { return _send_next - _send_base; }
+  uint32_t get_frame_timeout(const Transmit_Slot &slot) const;
+  bool find_frame_to_send(uint8_t &sequence, uint32_t now);
+  uint32_t get_ack_bitmap();
+  void encode_ack(uint8_t *buffer);
+  void process_ack(uint8_t next_expected, uint32_t bitmap, uint32_t now);
+  void process_send_base(uint8_t send_base, bool confirm, uint32_t now);
+  void process_data(uint8_t sequence, const uint8_t *data, uint16_t length, uint32_t now);
+  void deliver_receive_base();
+  void add_rtt_sample(uint32_t rtt);
+  void advance_send_base();
+
+public:
+  /**
+   * @brief Create a new ARQ endpoint
+   * @param config Timing configuration
+   * @param receive_function Function called with every received payload in order. Can be nullptr if only sending
+   */
+  Radio_Arq(const Config &config, Receive_Function receive_function = nullptr);
+
+  /**
+   * @brief Queue a payload for reliable delivery
+   * @param data Pointer to payload
+   * @param length Payload length, at most RADIO_ARQ_MAX_PAYLOAD_LENGTH
+   * @return True if queued, false if the window is full or the payload is too long
+   */
+  bool send(const uint8_t *data, uint16_t length);
+
+  /**
+   * @brief Build the next frame to transmit: a due retransmission, a new payload or a standalone ACK or skip notice
+   * @param frame Pointer to frame buffer
+   * @param frame_size Size of the frame buffer, RADIO_ARQ_MAX_FRAME_LENGTH is always enough
+   * @param now Current time in ms
+   * @return Frame length or 0 if nothing needs to be sent. Call mark_frame_sent() once the frame was actually transmitted
+   */
+  uint16_t build_frame(uint8_t *frame, uint16_t frame_size, uint32_t now = millis());
+
+  /**
+   * @brief Confirm that the last frame from build_frame() was transmitted
+   * @param now Current time in ms
+   */
+  void mark_frame_sent(uint32_t now = millis());
+
+  /**
+   * @brief Write an ACK-only frame, for example to piggyback on a telemetry packet. The pending ACK is considered sent
+   * @param buffer Pointer to at least RADIO_ARQ_ACK_LENGTH bytes
+   * @return Number of bytes written (always RADIO_ARQ_ACK_LENGTH)
+   */
+  uint8_t write_ack(uint8_t *buffer);
+
+  /**
+   * @brief Process a received frame
+   * @param frame Pointer to received bytes
+   * @param length Number of received bytes
+   * @param now Current time in ms
+   * @return True if this was an ARQ frame, false if it is something else and should be handled elsewhere
+   */
+  bool receive(const uint8_t *frame, uint16_t length, uint32_t now = millis());
+
+  /**
+   * @brief Exchange frames using a radio wrapper. Call often in the loop
+   * @tparam Radio Anything with transmit_bytes() and receive_bytes() like RadioLib_Wrapper
+   * @param radio Radio to use
+   * @param now Current time in ms
+   * @note Received frames that aren't ARQ frames are dropped. Use receive() and build_frame() directly when the channel is shared with other traffic
+   */
+  template <typename Radio>
+  void update(Radio &radio, uint32_t now = millis())
+  {
+    uint8_t frame[RADIO_ARQ_MAX_FRAME_LENGTH > 256 ? RADIO_ARQ_MAX_FRAME_LENGTH : 256];
+    uint16_t length = 0;
+    float rssi;
+    float snr;
+    double frequency;
+    if (radio.receive_bytes(frame, length, rssi, snr, frequency))
+    {
+      receive(frame, length, now);
+    }
+
+    length = build_frame(frame, sizeof(frame), now);
+    if (length != 0 && radio.transmit_bytes(frame, length))
+    {
+      mark_frame_sent(now);
+    }
+  }
+
+  /**
+   * @brief Check if everything that was sent has been acknowledged or given up
+   */
+  bool is_idle() const { return _send_base == _send_next; }
+
+  /**
+   * @brief Get number of payloads that can be queued with send()
+   */
+  uint8_t get_free_count() const { return RADIO_ARQ_WINDOW_SIZE - get_in_flight_count(); }
+
+  uint32_t get_retransmit_timeout() const { return _retransmit_timeout; }
+  uint32_t get_smoothed_rtt() const { return _smoothed_rtt; }
+  const Statistics &get_statistics() const { return _statistics; }
+
+  /**
+   * @brief Drop everything in flight and start from sequence number 0. Both sides must be reset together
+   */
+  void reset();
+};
+
+#endif // RADIOLIB_WRAPPER_ENABLE
@@ -0,0 +1,127 @@
+#pragma once
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include <Arduino.h>
+
+/*
+  Duty cycle limiter for the radio.
+
+  Keeps the time on air of the transmissions in a rolling window (for example 1 hour) and only admits a
+  new transmission if it still fits in the duty cycle budget of that window. When it doesn't, the next time
+  it will fit is reported, so telemetry can be sent as often as the limit allows instead of using fixed delays.
+
+  The window is split into RADIO_DUTY_CYCLE_BUCKETS buckets. A transmission is counted for one bucket longer
+  than the window, so the limit is never exceeded, only approached a little slower.
+
+  Example:
+    Radio_Duty_Cycle duty_cycle({0.01, 3600000}); // 1 % of every hour
+    if (duty_cycle.transmit_bytes(radio, bytes, length)) { sent }
+    else if (duty_cycle.get_next_transmit_time(radio.get_time_on_air(length), time)) { try again at time }
+*/
+
+// Number of buckets the window is split into
+#ifndef RADIO_DUTY_CYCLE_BUCKETS
+#define RADIO_DUTY_CYCLE_BUCKETS 20
+#endif
+
+class Radio_Duty_Cycle
+{
+public:
+  struct Config
+  {
+    float duty_cycle; // Allowed fraction of time spent transmitting (0 to 1)
+    uint32_t window;  // Length of the rolling window (ms)
+  };
+
+  struct Statistics
+  {
+    uint32_t admitted; // Transmissions that fit in the budget
+    uint32_t rejected; // Transmissions that had to wait
+  };
+
+private:
+  Config _config;
+  Statistics _statistics;
+  uint32_t _budget;       // Time on air allowed in the window (us)
+  uint32_t _bucket_width; // ms
+
+  // Time on air of each bucket (us), _newest_bucket collects the current transmissions until _bucket_end
+  uint32_t _buckets[RADIO_DUTY_CYCLE_BUCKETS + 1];
+  uint8_t _newest_bucket;
+  uint32_t _bucket_end;
+
+  void advance(uint32_t now);
+
+public:
+  /**
+   * @brief Create a new duty cycle limiter
+   * @param config Duty cycle and window length. The budget is limited to 71 minutes of time on air
+   * @param now Current time in ms
+   */
+  Radio_Duty_Cycle(const Config &config, uint32_t now = millis());
+
+  /**
+   * @brief Get the time on air used in the current window
+   * @param now Current time in ms
+   * @return uint32_t Time on air in microseconds
+   */
+  uint32_t get_used_time_on_air(uint32_t now = millis());
+
+  /**
+   * @brief Check if a transmission fits in the budget now
+   * @param time_on_air Time on air of the transmission in microseconds
+   * @param now Current time in ms
+   */
+  bool can_transmit(uint32_t time_on_air, uint32_t now = millis());
+
+  /**
+   * @brief Get the earliest time a transmission fits in the budget, if nothing else is transmitted before it
+   * @param time_on_air Time on air of the transmission in microseconds
+   * @param time Set to the time in ms, now if the transmission fits already
+   * @param now Current time in ms
+   * @return True if found, false if the transmission is longer than the whole budget and can never be sent
+   */
+  bool get_next_transmit_time(uint32_t time_on_air, uint32_t &time, uint32_t now = millis());
+
+  /**
+   * @brief Count a transmission that was made without transmit_bytes()
+   * @param time_on_air Time on air of the transmission in microseconds
+   * @param now Current time in ms
+   */
+  void add_transmission(uint32_t time_on_air, uint32_t now = millis());
+
+  /**
+   * @brief Transmit if the frame fits in the budget
+   * @tparam Radio Anything with get_time_on_air() and transmit_bytes() like RadioLib_Wrapper
+   * @param radio Radio to use
+   * @param bytes Pointer to frame
+   * @param length Frame length
+   * @param now Current time in ms
+   * @return True if the transmission was started, false if it doesn't fit in the budget or the radio is busy
+   */
+  template <typename Radio>
+  bool transmit_bytes(Radio &radio, uint8_t *bytes, size_t length, uint32_t now = millis())
+  {
+    uint32_t time_on_air = radio.get_time_on_air(length);
+    if (!can_transmit(time_on_air, now))
+    {
+      _statistics.rejected++;
+      return false;
+    }
+    if (!radio.transmit_bytes(bytes, length))
+    {
+      return false;
+    }
+    add_transmission(time_on_air, now);
+    _statistics.admitted++;
+    return true;
+  }
+
+  /**
+   * @brief Get the time on air allowed in the window in microseconds
+   */
+  uint32_t get_budget() const { return _budget; }
+
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // RADIOLIB_WRAPPER_ENABLE
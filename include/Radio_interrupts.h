@@ -0,0 +1,52 @@
+/*
+  Per radio interrupt flags, so several radios (RadioLib wrappers and the ranging wrapper) can be used at once.
+
+  RadioLib interrupt actions are plain functions without arguments, so a fixed table of trampoline
+  functions is used. Each radio attaches its own flag to a free table slot and gives the slot's
+  function to RadioLib. When the interrupt fires, the function marks only that radio's flag as done.
+*/
+#pragma once
+#if defined(RADIOLIB_WRAPPER_ENABLE) || defined(RANGING_WRAPPER_ENABLE)
+#include <Arduino.h>
+
+// Number of radios that can have interrupts attached at the same time (at most 4)
+#ifndef RADIO_INTERRUPTS_MAX_RADIOS
+#define RADIO_INTERRUPTS_MAX_RADIOS 4
+#endif
+
+static_assert(RADIO_INTERRUPTS_MAX_RADIOS >= 1 && RADIO_INTERRUPTS_MAX_RADIOS <= 4, "RADIO_INTERRUPTS_MAX_RADIOS must be between 1 and 4");
+
+namespace RadioLib_interrupts
+{
+    // Completion state of one radio, written by the interrupt
+    struct Action_Flag
+    {
+        volatile bool done = true;
+        volatile uint32_t time = 0; // millis() when the last action finished
+    };
+
+    /**
+     * @brief Attach a flag to a free interrupt slot
+     *
+     * @param flag Flag that the slot's interrupt function will set. Must stay valid until detached
+     * @return int8_t Slot index or -1 if all slots are in use
+     */
+    int8_t attach(Action_Flag *flag);
+
+    /**
+     * @brief Free an interrupt slot
+     *
+     * @param slot Slot index returned by attach()
+     */
+    void detach(int8_t slot);
+
+    /**
+     * @brief Get the interrupt function of a slot, to be passed to RadioLib
+     *
+     * @param slot Slot index returned by attach()
+     * @return Interrupt function that marks the attached flag as done
+     */
+    void (*get_interrupt_function(int8_t slot))(void);
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE || RANGING_WRAPPER_ENABLE
@@ -0,0 +1,194 @@
+#pragma once
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include <Arduino.h>
+
+/*
+  TDMA (time division multiple access) for several nodes on one frequency.
+
+  Time is divided into superframes. Each superframe starts with a beacon slot, followed by slot_count data
+  slots that are assigned to the nodes. The master (node 0) sends a beacon in the beacon slot, the other
+  nodes align their superframes to the beacon and only transmit in their own slots, so there are no collisions.
+
+    | beacon | slot 0 | slot 1 | ... | slot N-1 | beacon | slot 0 | ...
+    Every slot: | guard | timing margin + frame time on air | guard |
+
+  Slot lengths follow the time on air of the longest frame, the timing margin lets the transmission start late. The guard time covers the clock error built up
+  until the next beacon (also if max_missed_beacons beacons are missed) plus the timing margin for
+  interrupt and loop latency. Nodes measure the superframe length of the master with their own clock from
+  the beacon timestamps, so the clock drift between the nodes is corrected. A node that misses more than
+  max_missed_beacons beacons in a row stops transmitting until it receives a beacon again.
+
+  The beacon timestamp must be the time the receive done interrupt happened, so receive with the
+  RadioLib wrapper receive ring (start_receive_buffering() and read_received_bytes()). The ring is disabled
+  by default, so set RADIOLIB_WRAPPER_RX_RING_LENGTH in the build flags.
+
+  Beacon format:
+    byte 0 - RADIO_TDMA_FRAME_MARKER | RADIO_TDMA_BEACON
+    byte 1 - superframe counter
+    byte 2 - how late the beacon was sent after its scheduled time (ms)
+
+  Example (in the loop):
+    radio.poll();
+    while (radio.read_received_bytes(frame, sizeof(frame), length, metadata))
+    {
+      if (!tdma.receive(frame, length, metadata.timestamp)) { handle data }
+    }
+    length = tdma.build_beacon(frame, sizeof(frame));
+    if (length != 0 && radio.transmit_bytes(frame, length)) tdma.mark_beacon_sent();
+    if (has_data) tdma.transmit_bytes(radio, data, data_length);
+*/
+
+const uint8_t RADIO_TDMA_FRAME_MARKER = 0xC0;
+const uint8_t RADIO_TDMA_FRAME_MARKER_MASK = 0xF0;
+const uint8_t RADIO_TDMA_BEACON = 0x01;
+const uint8_t RADIO_TDMA_BEACON_LENGTH = 3;
+const uint8_t RADIO_TDMA_MASTER_NODE = 0;
+
+class Radio_Tdma
+{
+public:
+  struct Config
+  {
+    uint8_t node_id;             // This node. RADIO_TDMA_MASTER_NODE sends the beacons
+    const uint8_t *slot_owners;  // Node that owns each data slot. A node can own several slots. Must stay valid
+    uint8_t slot_count;          // Number of data slots
+    uint32_t beacon_time_on_air; // Time on air of the beacon (us), radio.get_time_on_air(RADIO_TDMA_BEACON_LENGTH)
+    uint32_t max_time_on_air;    // Time on air of the longest data frame (us)
+    float clock_tolerance;       // Clock accuracy of every node (ppm)
+    uint32_t timing_margin;      // Interrupt and loop latency (ms)
+    uint8_t max_missed_beacons;  // Stop transmitting after missing more beacons than this in a row
+  };
+
+  struct Statistics
+  {
+    uint32_t beacons_sent;
+    uint32_t beacons_skipped;  // Master: beacons not sent, because the radio was busy for the whole beacon slot
+    uint32_t beacons_received;
+    uint32_t sync_losses;      // Times too many beacons were missed
+    uint32_t frames_sent;      // Data frames sent with transmit_bytes()
+    uint32_t frames_deferred;  // Data frames that didn't fit in the current slot
+  };
+
+private:
+  Config _config;
+  Statistics _statistics;
+
+  // Layout in the master clock (ms)
+  uint32_t _guard_time;
+  uint32_t _beacon_slot_length;
+  uint32_t _slot_length;
+  uint32_t _superframe_length;
+
+  // Start of the reference superframe in the local clock and the superframe length measured in the local clock
+  bool _synchronized;
+  uint32_t _reference_time;
+  float _local_superframe_length;
+  uint8_t _reference_counter;
+
+  // Beacon the superframe length is measured from
+  uint32_t _baseline_time;
+  uint32_t _baseline_superframes;
+
+  // Master: beacon of the current superframe was sent (or skipped), beacon built by build_beacon()
+  bool _beacon_sent;
+  bool _built_beacon;
+
+  bool get_superframe(uint32_t now, uint32_t &start, uint8_t &counter, float &scale);
+
+public:
+  /**
+   * @brief Create a new TDMA scheduler
+   * @param config Node, slot assignment and timing configuration
+   * @param now Current time in ms. The master starts the first superframe now
+   */
+  Radio_Tdma(const Config &config, uint32_t now = millis());
+
+  /**
+   * @brief Get the guard time needed with these settings
+   * @param config TDMA configuration
+   * @return uint32_t Guard time at both ends of every slot (ms)
+   */
+  static uint32_t get_guard_time(const Config &config);
+
+  /**
+   * @brief Build the beacon if it is time to send it. Only does something on the master
+   * @param frame Pointer to at least RADIO_TDMA_BEACON_LENGTH bytes
+   * @param frame_size Size of the frame buffer
+   * @param now Current time in ms
+   * @return Frame length or 0 if nothing needs to be sent. Transmit it right away and call mark_beacon_sent()
+   */
+  uint16_t build_beacon(uint8_t *frame, uint16_t frame_size, uint32_t now = millis());
+
+  /**
+   * @brief Confirm that the beacon from build_beacon() was transmitted
+   */
+  void mark_beacon_sent();
+
+  /**
+   * @brief Process a received frame
+   * @param frame Pointer to received bytes
+   * @param length Number of received bytes
+   * @param arrival_time Time the frame reception ended (receive done interrupt) in ms
+   * @return True if this was a beacon, false if it should be handled elsewhere
+   */
+  bool receive(const uint8_t *frame, uint16_t length, uint32_t arrival_time);
+
+  /**
+   * @brief Check if a frame can be transmitted now without leaving this node's slot
+   * @param time_on_air Time on air of the frame in microseconds
+   * @param now Current time in ms
+   */
+  bool can_transmit(uint32_t time_on_air, uint32_t now = millis());
+
+  /**
+   * @brief Get the next time a frame can be transmitted
+   * @param time_on_air Time on air of the frame in microseconds
+   * @param time Set to the time in ms, now if the frame can be transmitted already
+   * @param now Current time in ms
+   * @return True if found, false if not synchronized, this node has no slots or the frame is too long for a slot
+   */
+  bool get_next_transmit_time(uint32_t time_on_air, uint32_t &time, uint32_t now = millis());
+
+  /**
+   * @brief Transmit if the frame fits in this node's slot now
+   * @tparam Radio Anything with get_time_on_air() and transmit_bytes() like RadioLib_Wrapper
+   * @param radio Radio to use
+   * @param bytes Pointer to frame
+   * @param length Frame length
+   * @param now Current time in ms
+   * @return True if the transmission was started, false if it is not this node's turn or the radio is busy
+   */
+  template <typename Radio>
+  bool transmit_bytes(Radio &radio, uint8_t *bytes, size_t length, uint32_t now = millis())
+  {
+    if (!can_transmit(radio.get_time_on_air(length), now))
+    {
+      _statistics.frames_deferred++;
+      return false;
+    }
+    if (!radio.transmit_bytes(bytes, length))
+    {
+      return false;
+    }
+    _statistics.frames_sent++;
+    return true;
+  }
+
+  /**
+   * @brief Check if the superframes are aligned to the master. Always true on the master
+   * @param now Current time in ms
+   */
+  bool is_synchronized(uint32_t now = millis());
+
+  /**
+   * @brief Get the length of the superframe measured with the local clock (ms)
+   */
+  float get_local_superframe_length() const { return _local_superframe_length; }
+
+  uint32_t get_guard_time() const { return _guard_time; }
+  uint32_t get_slot_length() const { return _slot_length; }
+  uint32_t get_superframe_length() const { return _superframe_length; }
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+#endif // RADIOLIB_WRAPPER_ENABLE
@@ -0,0 +1,113 @@
+/*
+  LoRa time on air model for the SX126x, SX127x (and RFM9x) and SX128x radio families.
+
+  Follows the formulas in the Semtech datasheets:
+    symbol time    = 2^SF / BW
+    payload bits   = 8 x length + 16 (CRC) - 4 x SF + 8 (SF7 and above) + 20 (explicit header)
+    payload        = 8 + ceil(payload bits / (4 x (SF - 2 x LDRO))) x coding rate denominator  symbols
+    time on air    = (preamble + 4.25 (6.25 for SF5 and SF6) + payload) x symbol time
+  Low data rate optimization (LDRO) is used when the symbol time is 16 ms or longer (the same rule RadioLib
+  uses for SX126x and SX127x), the SX128x uses it for SF11 and SF12.
+
+  Everything is constexpr, so the time on air of fixed size packets can be checked at compile time:
+    static_assert(Radio_Time_On_Air::get_time_on_air(Radio_Time_On_Air::Chip_Family::Sx126x, 7, 125, 5, 10) == 41216, "");
+*/
+#pragma once
+#include <Arduino.h>
+
+namespace Radio_Time_On_Air
+{
+  enum class Chip_Family
+  {
+    Sx126x,
+    Sx127x, // Also RFM9x
+    Sx128x,
+  };
+
+  // RadioLib defaults, the wrappers don't change these
+  constexpr uint16_t DEFAULT_PREAMBLE_LENGTH = 8;
+
+  /**
+   * @brief Get the duration of one LoRa symbol
+   * @param spreading Spreading factor (5 to 12)
+   * @param signal_bw Bandwidth in kHz
+   * @return float Symbol time in microseconds
+   */
+  constexpr float get_symbol_time(uint8_t spreading, float signal_bw)
+  {
+    return (static_cast<uint32_t>(1) << spreading) * 1000 / signal_bw;
+  }
+
+  /**
+   * @brief Check if the radio uses low data rate optimization with these settings
+   * @param family Radio chip family
+   * @param spreading Spreading factor
+   * @param signal_bw Bandwidth in kHz
+   */
+  constexpr bool uses_low_data_rate_optimization(Chip_Family family, uint8_t spreading, float signal_bw)
+  {
+    return family == Chip_Family::Sx128x ? spreading >= 11 : get_symbol_time(spreading, signal_bw) >= 16000;
+  }
+
+  /**
+   * @brief Get the number of payload bits before rounding up to whole blocks, can be negative for short packets
+   * @param spreading Spreading factor (5 to 12)
+   * @param length Payload length in bytes
+   * @param crc True if the payload CRC is enabled
+   * @param explicit_header True if the explicit header is used
+   */
+  constexpr int32_t get_payload_bits(uint8_t spreading, size_t length, bool crc, bool explicit_header)
+  {
+    return 8 * static_cast<int32_t>(length) - 4 * spreading + (crc ? 16 : 0) + (spreading < 7 ? 0 : 8) + (explicit_header ? 20 : 0);
+  }
+
+  /**
+   * @brief Get the number of payload symbols
+   * @param payload_bits Payload bits from get_payload_bits()
+   * @param bits_per_block Bits in one block of coding_rate symbols
+   * @param coding_rate Coding rate denominator (5 to 8)
+   */
+  constexpr uint32_t get_payload_symbols(int32_t payload_bits, int32_t bits_per_block, uint8_t coding_rate)
+  {
+    return 8 + (payload_bits > 0 ? (payload_bits + bits_per_block - 1) / bits_per_block * coding_rate : 0);
+  }
+
+  /**
+   * @brief Get the number of symbols in a packet, in quarter symbols so the fractional preamble is exact
+   * @param family Radio chip family
+   * @param spreading Spreading factor (5 to 12)
+   * @param signal_bw Bandwidth in kHz
+   * @param coding_rate Coding rate denominator (5 to 8)
+   * @param length Payload length in bytes
+   * @param preamble_length Preamble length in symbols
+   * @param crc True if the payload CRC is enabled
+   * @param explicit_header True if the explicit header is used
+   * @return uint32_t Packet length in quarter symbols
+   */
+  constexpr uint32_t get_quarter_symbol_count(Chip_Family family, uint8_t spreading, float signal_bw, uint8_t coding_rate, size_t length,
+                                              uint16_t preamble_length = DEFAULT_PREAMBLE_LENGTH, bool crc = true, bool explicit_header = true)
+  {
+    return 4 * (preamble_length + get_payload_symbols(get_payload_bits(spreading, length, crc, explicit_header),
+                                                      4 * (spreading - (uses_low_data_rate_optimization(family, spreading, signal_bw) ? 2 : 0)), coding_rate)) +
+           (spreading < 7 ? 25 : 17);
+  }
+
+  /**
+   * @brief Get the time a LoRa packet occupies the channel
+   * @param family Radio chip family
+   * @param spreading Spreading factor (5 to 12)
+   * @param signal_bw Bandwidth in kHz
+   * @param coding_rate Coding rate denominator (5 to 8)
+   * @param length Payload length in bytes
+   * @param preamble_length Preamble length in symbols
+   * @param crc True if the payload CRC is enabled
+   * @param explicit_header True if the explicit header is used
+   * @return uint32_t Time on air in microseconds
+   */
+  constexpr uint32_t get_time_on_air(Chip_Family family, uint8_t spreading, float signal_bw, uint8_t coding_rate, size_t length,
+                                     uint16_t preamble_length = DEFAULT_PREAMBLE_LENGTH, bool crc = true, bool explicit_header = true)
+  {
+    return static_cast<uint32_t>(get_quarter_symbol_count(family, spreading, signal_bw, coding_rate, length, preamble_length, crc, explicit_header) *
+                                 static_cast<double>(static_cast<uint32_t>(1) << spreading) * 250 / signal_bw);
+  }
+}
@@ -0,0 +1,118 @@
+/*
+  Reed-Solomon codec over GF(256), used for forward error correction of radio frames.
+
+  The field uses the primitive polynomial x^8 + x^4 + x^3 + x^2 + 1 (0x11D) and the
+  generator polynomial has the roots alpha^1 ... alpha^parity_symbols. The log and
+  exponent tables are generated at compile time.
+
+  Codewords are shortened: any data length up to 255 - parity_symbols can be used
+  and the missing leading symbols are treated as zeros. With 32 parity symbols
+  and 223 data symbols this is the classic RS(255,223) code.
+  Up to parity_symbols / 2 wrong symbols per codeword can be corrected.
+*/
+#pragma once
+#ifdef CCSDS_PACKETS_ENABLE
+#include <Arduino.h>
+#include "Compile_time_table.h"
+
+// Largest supported number of parity symbols per codeword
+#ifndef REED_SOLOMON_MAX_PARITY_SYMBOLS
+#define REED_SOLOMON_MAX_PARITY_SYMBOLS 32
+#endif
+
+namespace Galois_Field
+{
+  // Multiply a field element by alpha (x) and reduce by the primitive polynomial
+  constexpr uint8_t multiply_by_alpha(uint8_t value)
+  {
+    return (value & 0x80) ? static_cast<uint8_t>((value << 1) ^ 0x11D) : static_cast<uint8_t>(value << 1);
+  }
+
+  // alpha^power for power 0 ... 254. Only used to generate the tables
+  constexpr uint8_t calculate_exp(uint8_t power)
+  {
+    return power == 0 ? 1 : multiply_by_alpha(calculate_exp(power - 1));
+  }
+
+  // Power of alpha that gives value, searched starting from alpha^power. Only used to generate the tables
+  constexpr uint8_t calculate_log(uint8_t value, uint8_t power = 0, uint8_t alpha_power = 1)
+  {
+    return power == 255 ? 0 : alpha_power == value ? power : calculate_log(value, power + 1, multiply_by_alpha(alpha_power));
+  }
+
+  // Exponent table is doubled, so the sum of two logarithms can be used as an index without modulo
+  struct Tables
+  {
+    uint8_t exp[512];
+    uint8_t log[256]; // log[0] is undefined and set to 0, zero is handled separately
+
+    constexpr Tables() : Tables(Compile_Time_Table::Make_Index_List<512>::type(), Compile_Time_Table::Make_Index_List<256>::type()) {}
+
+    template <uint16_t... Exp_Indices, uint16_t... Log_Indices>
+    constexpr Tables(Compile_Time_Table::Index_List<Exp_Indices...>, Compile_Time_Table::Index_List<Log_Indices...>)
+        : exp{calculate_exp(Exp_Indices % 255)...}, log{calculate_log(Log_Indices)...}
+    {
+    }
+  };
+
+  extern const Tables TABLES;
+
+  inline uint8_t multiply(uint8_t a, uint8_t b)
+  {
+    if (a == 0 || b == 0)
+    {
+      return 0;
+    }
+    return TABLES.exp[TABLES.log[a] + TABLES.log[b]];
+  }
+
+  // b must not be zero
+  inline uint8_t divide(uint8_t a, uint8_t b)
+  {
+    if (a == 0)
+    {
+      return 0;
+    }
+    return TABLES.exp[TABLES.log[a] + 255 - TABLES.log[b]];
+  }
+
+  // alpha^power, power can be any non negative value
+  inline uint8_t power_of_alpha(uint16_t power)
+  {
+    return TABLES.exp[power % 255];
+  }
+}
+
+class Reed_Solomon
+{
+private:
+  uint8_t _parity_symbols;
+  uint8_t _generator[REED_SOLOMON_MAX_PARITY_SYMBOLS + 1]; // Coefficient of x^i at index i
+
+public:
+  /**
+   * @brief Create a new codec
+   * @param parity_symbols Number of parity symbols per codeword. Even, at most REED_SOLOMON_MAX_PARITY_SYMBOLS
+   */
+  Reed_Solomon(uint8_t parity_symbols);
+
+  /**
+   * @brief Calculate the parity symbols of a codeword
+   * @param data Pointer to data symbols
+   * @param data_length Number of data symbols, at most 255 - parity symbols
+   * @param parity Pointer to where the parity symbols are written
+   */
+  void encode(const uint8_t *data, uint8_t data_length, uint8_t *parity) const;
+
+  /**
+   * @brief Find and correct errors in a codeword in place
+   * @param codeword Pointer to the data symbols followed by the parity symbols
+   * @param length Total codeword length, at most 255
+   * @return Number of corrected symbols or -1 if there are too many errors to correct
+   */
+  int16_t decode(uint8_t *codeword, uint8_t length) const;
+
+  uint8_t get_parity_symbols() const { return _parity_symbols; }
+};
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,224 @@
+#pragma once
+#ifdef SIMULATED_RADIO_ENABLE
+#include <RadioLib.h>
+#include <Arduino.h>
+#include "Radio_time_on_air.h"
+
+/*
+  Simulated LoRa radio for testing protocols on a workstation without hardware.
+
+  Simulated_Radio has the part of the RadioLib interface that RadioLib_Wrapper uses, so RadioLib_Wrapper<Simulated_Radio>
+  works like with a real SX12xx chip. All radios attached to the same Simulated_Air can hear each other:
+    - a frame occupies the channel for its time on air (Radio_Time_On_Air with the radio's modulation)
+    - only radios that are receiving for the whole frame with the same frequency, spreading factor, bandwidth and
+      sync word get it. Frames that overlap on the same channel collide and are lost
+    - every receiver independently loses the frame with the configured probability and gets bit errors with the
+      configured bit error rate. With CRC enabled readData() reports RADIOLIB_ERR_CRC_MISMATCH for corrupted frames,
+      without it the corrupted bytes are delivered (useful for testing FEC)
+    - the receive interrupt happens latency microseconds after the frame ends
+  Time comes from micros(), so a host Arduino layer with a controllable clock makes the simulation deterministic.
+  The air only moves forward in Simulated_Air::update() and when a radio calls startTransmit(), so call update() in the loop
+  (for example before poll()).
+
+  Example:
+    Simulated_Air::get_default().set_config({0.1, 0.0001, 1000, -80, 10, 0, 1, true, 1});
+    RadioLib_Wrapper<Simulated_Radio> ground, rocket; // Both use the default air after begin()
+*/
+
+// Radios that can be attached to one air
+#ifndef SIMULATED_AIR_MAX_RADIOS
+#define SIMULATED_AIR_MAX_RADIOS 8
+#endif
+
+// Frames that can be in the air or waiting for delivery at once
+#ifndef SIMULATED_AIR_MAX_FRAMES
+#define SIMULATED_AIR_MAX_FRAMES 16
+#endif
+
+static_assert(SIMULATED_AIR_MAX_RADIOS <= 32, "SIMULATED_AIR_MAX_RADIOS can't be more than 32");
+
+const uint16_t SIMULATED_RADIO_MAX_FRAME_LENGTH = 255;
+
+class Simulated_Radio;
+
+class Simulated_Air
+{
+public:
+  struct Config
+  {
+    float loss;                // Probability that a receiver loses a frame (0 to 1)
+    float bit_error_rate;      // Probability of every received bit being flipped (0 to 1)
+    uint32_t latency;          // Time from the end of the frame to the receive interrupt (us)
+    float rssi;                // Reported for received frames (dBm)
+    float snr;                 // Reported for received frames (dB)
+    double frequency_error;    // Offset of the transmitted carrier from its set frequency, added to the frequency difference of the radios (Hz)
+    float time_on_air_scale;   // Multiplier of the time on air, 0 delivers frames instantly
+    bool crc;                  // True if corrupted frames are detected
+    uint32_t seed;             // Random number generator seed, runs with the same seed are identical
+  };
+
+  struct Statistics
+  {
+    uint32_t frames_sent;      // Transmissions started
+    uint32_t frames_delivered; // Frames received (one per receiver)
+    uint32_t frames_lost;      // Frames lost because of the loss probability
+    uint32_t frames_corrupted; // Delivered frames with bit errors
+    uint32_t collisions;       // Frames lost because they overlapped with another frame
+    uint32_t aborted;          // Transmissions stopped with standby() before they finished
+    uint32_t overflows;        // Frames dropped, because SIMULATED_AIR_MAX_FRAMES were already in the air
+  };
+
+  static const Config DEFAULT_CONFIG;
+
+private:
+  struct Frame
+  {
+    bool used;
+    uint8_t data[SIMULATED_RADIO_MAX_FRAME_LENGTH];
+    uint16_t length;
+    uint8_t sender;
+    uint32_t start;           // us
+    uint32_t end;             // us
+    uint32_t delivery_time;   // us
+    uint32_t listeners;       // Bit mask of the radios that have been receiving since the frame started
+    bool collided;
+    bool aborted;
+    float frequency;          // MHz
+    float signal_bw;          // kHz
+    uint8_t spreading;
+    uint8_t sync_word;
+  };
+
+  Config _config;
+  Statistics _statistics;
+  uint32_t _random_state;
+  Simulated_Radio *_radios[SIMULATED_AIR_MAX_RADIOS];
+  Frame _frames[SIMULATED_AIR_MAX_FRAMES];
+
+  uint32_t next_random();
+  float next_random_float();
+  bool is_same_channel(const Frame &frame, const Simulated_Radio &radio) const;
+  void deliver(Frame &frame);
+
+  // Used by Simulated_Radio
+  friend class Simulated_Radio;
+  bool attach(Simulated_Radio *radio);
+  void detach(Simulated_Radio *radio);
+  void start_transmit(Simulated_Radio *radio, const uint8_t *data, uint16_t length, uint32_t time_on_air, uint32_t now);
+  void stop_listening(Simulated_Radio *radio);
+  void abort_transmit(Simulated_Radio *radio, uint32_t now);
+
+public:
+  Simulated_Air(const Config &config = DEFAULT_CONFIG);
+
+  /**
+   * @brief Get the air radios attach to in begin()
+   */
+  static Simulated_Air &get_default();
+
+  /**
+   * @brief Change the channel model. The random number generator is seeded again
+   * @param config New channel model
+   */
+  void set_config(const Config &config);
+
+  /**
+   * @brief Finish transmissions and deliver frames that are due, calls the interrupt functions of the radios
+   * @param now Current time in us
+   */
+  void update(uint32_t now = micros());
+
+  const Config &get_config() const { return _config; }
+  const Statistics &get_statistics() const { return _statistics; }
+};
+
+class Simulated_Radio
+{
+private:
+  friend class Simulated_Air;
+
+  enum class State
+  {
+    Standby,
+    Transmit,
+    Receive,
+  };
+
+  Simulated_Air *_air;
+  uint8_t _index; // Position in the air
+  State _state;
+  uint32_t _transmit_end;
+  void (*_action)(void);
+  Radio_Time_On_Air::Chip_Family _family;
+
+  // Modulation
+  float _frequency;
+  float _signal_bw;
+  uint8_t _spreading;
+  uint8_t _coding_rate;
+  uint8_t _sync_word;
+  int8_t _tx_power;
+
+  // Last received frame
+  uint8_t _rx_data[SIMULATED_RADIO_MAX_FRAME_LENGTH];
+  uint16_t _rx_length;
+  bool _rx_corrupted;
+  float _rx_rssi;
+  float _rx_snr;
+  double _rx_frequency_error;
+
+  void set_state(State state);
+
+public:
+  /**
+   * @brief Create a new simulated radio. The module is ignored, it is only needed to match the RadioLib radio constructors
+   */
+  Simulated_Radio(Module *module = nullptr);
+
+  // Copies don't take over the place in the air, the radio is attached again in begin()
+  Simulated_Radio(const Simulated_Radio &other);
+  Simulated_Radio &operator=(const Simulated_Radio &other);
+  ~Simulated_Radio();
+
+  /**
+   * @brief Attach to another air than the default one
+   * @param air Air to use
+   * @return True if attached, false if the air has no room for more radios
+   */
+  bool set_air(Simulated_Air &air);
+
+  /**
+   * @brief Select the chip family used for the time on air. Sx126x by default
+   */
+  void set_chip_family(Radio_Time_On_Air::Chip_Family family) { _family = family; }
+
+  // RadioLib interface
+  int16_t begin(float freq = 434.0, float bw = 125.0, uint8_t sf = 9, uint8_t cr = 7, uint8_t syncWord = 0x12, int8_t power = 10);
+  int16_t setFrequency(float freq);
+  int16_t setBandwidth(float bw);
+  int16_t setSpreadingFactor(uint8_t sf);
+  int16_t setCodingRate(uint8_t cr);
+  int16_t setSyncWord(uint8_t syncWord);
+  int16_t setOutputPower(int8_t power);
+  int16_t setDio2AsRfSwitch(bool /* enable */ = true) { return RADIOLIB_ERR_NONE; }
+  void setRfSwitchPins(uint32_t /* rxEn */, uint32_t /* txEn */) {}
+  int16_t setRxBoostedGainMode(bool /* rxbgm */, bool /* persist */ = true) { return RADIOLIB_ERR_NONE; }
+  void setPacketReceivedAction(void (*func)(void)) { _action = func; }
+
+  int16_t standby();
+  int16_t startTransmit(uint8_t *data, size_t len, uint8_t addr = 0);
+  int16_t startTransmit(String &str, uint8_t addr = 0);
+  int16_t finishTransmit();
+  int16_t transmit(uint8_t *data, size_t len, uint8_t addr = 0);
+  int16_t transmit(String &str, uint8_t addr = 0);
+  int16_t startReceive();
+  int16_t readData(uint8_t *data, size_t len);
+  int16_t readData(String &str, size_t len = 0);
+  size_t getPacketLength(bool update = true);
+  float getRSSI() { return _rx_rssi; }
+  float getSNR() { return _rx_snr; }
+  double getFrequencyError() { return _rx_frequency_error; }
+  uint32_t getTimeOnAir(size_t len);
+};
+
+#endif // SIMULATED_RADIO_ENABLE
@@ -3,6 +3,7 @@
 #ifdef RANGING_WRAPPER_ENABLE
 
 #include <RadioLib.h>
+#include "Radio_interrupts.h"
 
 class Ranging_Wrapper
 {
@@ -73,6 +74,11 @@ private:
     unsigned long _ranging_start_time = 0;
     int _lora_range_state;
 
+    // Set by the interrupt when ranging has finished
+    RadioLib_interrupts::Action_Flag _ranging_flag;
+    int8_t _interrupt_slot = -1;
+    bool is_ranging() { return !_ranging_flag.done; }
+
     Mode _mode;
     Lora_Device _config;
     double distance_between_earth_cordinates_m(Position p1, Position p2);
@@ -80,6 +86,17 @@ private:
     String begin_lora(Mode mode, Lora_Device config);
 
 public:
+    Ranging_Wrapper() = default;
+
+    /**
+     * @brief Frees the interrupt slot and the radio module
+     */
+    ~Ranging_Wrapper();
+
+    // The wrapper owns its interrupt slot and radio module, so it can't be copied
+    Ranging_Wrapper(const Ranging_Wrapper &) = delete;
+    Ranging_Wrapper &operator=(const Ranging_Wrapper &) = delete;
+
     String init(Mode mode, Lora_Device config);
     bool master_read(Ranging_Slave slave, Ranging_Result &result, long int timeout);
     bool slave_reenable(long int timeout, Ranging_Slave slave);
@@ -0,0 +1,84 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_aggregator.h"
+
+Ccsds_Aggregator::Ccsds_Aggregator(const Config &config)
+{
+  _config = config;
+  if (_config.max_frame_length > CCSDS_MAX_FRAME_LENGTH || _config.max_frame_length == 0)
+  {
+    _config.max_frame_length = CCSDS_MAX_FRAME_LENGTH;
+  }
+  clear();
+}
+
+void Ccsds_Aggregator::clear()
+{
+  _frame_length = 0;
+  _packet_count = 0;
+  _first_packet_time = 0;
+}
+
+bool Ccsds_Aggregator::add(const uint8_t *packet, uint16_t length, unsigned long now)
+{
+  if (length > get_free_length())
+  {
+    return false;
+  }
+  if (_config.max_packets != 0 && _packet_count >= _config.max_packets)
+  {
+    return false;
+  }
+
+  // The deadline is counted from the oldest packet in the frame
+  if (_packet_count == 0)
+  {
+    _first_packet_time = now;
+  }
+
+  memcpy(_frame + _frame_length, packet, length);
+  _frame_length += length;
+  _packet_count++;
+  return true;
+}
+
+bool Ccsds_Aggregator::is_flush_due(unsigned long now) const
+{
+  if (_packet_count == 0)
+  {
+    return false;
+  }
+  if (_config.max_packets != 0 && _packet_count >= _config.max_packets)
+  {
+    return true;
+  }
+  // No other packet can fit, so there is no reason to wait
+  if (get_free_length() < CCSDS_TELEMETRY_HEADER_LENGTH + CCSDS_CRC_LENGTH)
+  {
+    return true;
+  }
+  return now - _first_packet_time >= _config.flush_deadline;
+}
+
+uint8_t split_ccsds_frame(const uint8_t *frame, uint16_t frame_length, void (*packet_function)(const Ccsds_Packet_View &), Ccsds_Packet_View::Layout layout)
+{
+  uint8_t packets = 0;
+  uint16_t offset = 0;
+  while (offset + CCSDS_PRIMARY_HEADER_LENGTH <= frame_length)
+  {
+    Ccsds_Packet_View view(frame + offset, frame_length - offset, layout);
+    if (!view.is_valid())
+    {
+      // Search for the next packet start byte by byte
+      offset++;
+      continue;
+    }
+
+    uint16_t packet_length = view.get_packet_length();
+    packet_function(Ccsds_Packet_View(frame + offset, packet_length, layout));
+    packets++;
+    offset += packet_length;
+  }
+  return packets;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,171 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_compression.h"
+
+// Mask with the bits used by a field of the given size
+static uint64_t field_mask(uint8_t size)
+{
+  return size >= 8 ? UINT64_MAX : (static_cast<uint64_t>(1) << (size * 8)) - 1;
+}
+
+// Difference of two field values, wrapped to the field size and sign extended
+static int64_t field_delta(uint64_t value, uint64_t keyframe_value, uint8_t size)
+{
+  uint64_t difference = (value - keyframe_value) & field_mask(size);
+  uint8_t sign_bit = size * 8 - 1;
+  if (size < 8 && ((difference >> sign_bit) & 0x01))
+  {
+    difference |= ~field_mask(size);
+  }
+  return static_cast<int64_t>(difference);
+}
+
+// Write an unsigned LEB128 varint, returns the number of bytes written or 0 if it doesn't fit
+static uint8_t write_varint(uint8_t *buffer, uint16_t buffer_size, uint64_t value)
+{
+  uint8_t length = 0;
+  do
+  {
+    if (length >= buffer_size)
+    {
+      return 0;
+    }
+    uint8_t byte_value = value & 0x7F;
+    value >>= 7;
+    buffer[length++] = byte_value | (value != 0 ? 0x80 : 0x00);
+  } while (value != 0);
+  return length;
+}
+
+// Read an unsigned LEB128 varint, returns the number of bytes read or 0 if it is malformed
+static uint8_t read_varint(const uint8_t *buffer, uint16_t buffer_size, uint64_t &value)
+{
+  value = 0;
+  for (uint8_t length = 0; length < buffer_size && length < 10; length++)
+  {
+    value |= static_cast<uint64_t>(buffer[length] & 0x7F) << (7 * length);
+    if ((buffer[length] & 0x80) == 0)
+    {
+      return length + 1;
+    }
+  }
+  return 0;
+}
+
+Ccsds_Delta_Encoder::Ccsds_Delta_Encoder(const Ccsds_Decode_Plan &plan, uint16_t keyframe_interval)
+{
+  _plan = plan;
+  _keyframe_interval = keyframe_interval == 0 ? 1 : keyframe_interval;
+  _keyframe_id = CCSDS_COMPRESSION_KEYFRAME_ID_MASK; // First keyframe gets id 0
+  _packets_since_keyframe = 0;
+  _has_keyframe = false;
+}
+
+uint16_t Ccsds_Delta_Encoder::encode(uint8_t *ccsds_data, uint16_t data_length, const Converter *data_values)
+{
+  if (ccsds_data == nullptr || data_length < 1)
+  {
+    return 0;
+  }
+
+  // Keyframe with absolute values
+  if (!_has_keyframe || _packets_since_keyframe >= _keyframe_interval - 1)
+  {
+    uint16_t values_length = write_ccsds_data_values(ccsds_data + 1, data_length - 1, data_values, _plan);
+    if (values_length == 0 && _plan.data_length != 0)
+    {
+      return 0;
+    }
+    _keyframe_id = (_keyframe_id + 1) & CCSDS_COMPRESSION_KEYFRAME_ID_MASK;
+    ccsds_data[0] = _keyframe_id;
+    memcpy(_keyframe_values, data_values, _plan.field_count * sizeof(Converter));
+    _packets_since_keyframe = 0;
+    _has_keyframe = true;
+    return 1 + values_length;
+  }
+
+  // Delta packet
+  ccsds_data[0] = CCSDS_COMPRESSION_DELTA_FLAG | _keyframe_id;
+  uint16_t length = 1;
+  for (uint8_t i = 0; i < _plan.field_count; i++)
+  {
+    uint8_t size = get_ccsds_field_size(_plan.fields[i].type);
+    int64_t delta = field_delta(get_ccsds_field_raw_value(data_values[i], _plan, i), get_ccsds_field_raw_value(_keyframe_values[i], _plan, i), size);
+    uint64_t zigzag = (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63);
+    uint8_t varint_length = write_varint(ccsds_data + length, data_length - length, zigzag);
+    if (varint_length == 0)
+    {
+      return 0;
+    }
+    length += varint_length;
+  }
+  _packets_since_keyframe++;
+  return length;
+}
+
+bool Ccsds_Delta_Encoder::append(Ccsds_Packet_Builder &builder, const Converter *data_values)
+{
+  // Encode into the free space of the packet and then reserve only the used part
+  uint16_t free_length = builder.get_remaining_length();
+  uint8_t *destination = builder.reserve(0);
+  if (destination == nullptr)
+  {
+    return false;
+  }
+  uint16_t length = encode(destination, free_length, data_values);
+  if (length == 0)
+  {
+    return false;
+  }
+  builder.reserve(length);
+  return true;
+}
+
+bool extract_ccsds_data_values(const uint8_t *ccsds_data, uint16_t data_length, Converter *data_values, Ccsds_Delta_Decoder &decoder)
+{
+  if (ccsds_data == nullptr || data_length < 1)
+  {
+    return false;
+  }
+
+  uint8_t compression_header = ccsds_data[0];
+  uint8_t keyframe_id = compression_header & CCSDS_COMPRESSION_KEYFRAME_ID_MASK;
+
+  // Keyframe with absolute values
+  if ((compression_header & CCSDS_COMPRESSION_DELTA_FLAG) == 0)
+  {
+    if (!extract_ccsds_data_values(ccsds_data + 1, data_length - 1, data_values, decoder.plan))
+    {
+      return false;
+    }
+    memcpy(decoder.keyframe_values, data_values, decoder.plan.field_count * sizeof(Converter));
+    decoder.keyframe_id = keyframe_id;
+    decoder.has_keyframe = true;
+    return true;
+  }
+
+  // Delta packet needs its keyframe
+  if (!decoder.has_keyframe || decoder.keyframe_id != keyframe_id)
+  {
+    return false;
+  }
+
+  uint16_t offset = 1;
+  for (uint8_t i = 0; i < decoder.plan.field_count; i++)
+  {
+    uint64_t zigzag;
+    uint8_t varint_length = read_varint(ccsds_data + offset, data_length - offset, zigzag);
+    if (varint_length == 0)
+    {
+      return false;
+    }
+    offset += varint_length;
+
+    int64_t delta = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 0x01);
+    uint8_t size = get_ccsds_field_size(decoder.plan.fields[i].type);
+    uint64_t keyframe_value = get_ccsds_field_raw_value(decoder.keyframe_values[i], decoder.plan, i);
+    set_ccsds_field_raw_value(data_values[i], (keyframe_value + static_cast<uint64_t>(delta)) & field_mask(size), decoder.plan, i);
+  }
+  return true;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
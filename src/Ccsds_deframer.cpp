@@ -0,0 +1,113 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_deframer.h"
+
+Ccsds_Deframer::Ccsds_Deframer(Ccsds_Packet_View::Layout layout)
+{
+  _layout = layout;
+  reset();
+}
+
+void Ccsds_Deframer::reset()
+{
+  _start = 0;
+  _end = 0;
+  _emitted_length = 0;
+  _statistics = {0, 0};
+}
+
+void Ccsds_Deframer::consume(uint16_t length)
+{
+  _start += length;
+  // Restart from the beginning of the buffer when it is empty, so no data has to be moved
+  if (_start == _end)
+  {
+    _start = 0;
+    _end = 0;
+  }
+}
+
+size_t Ccsds_Deframer::push(const uint8_t *data, size_t length)
+{
+  // Remove the packet that was returned by the last next() call
+  consume(_emitted_length);
+  _emitted_length = 0;
+
+  // Move the unprocessed bytes to the start if there isn't enough space after them
+  if (_start > 0 && sizeof(_buffer) - _end < length)
+  {
+    memmove(_buffer, _buffer + _start, _end - _start);
+    _end -= _start;
+    _start = 0;
+  }
+
+  size_t accepted = sizeof(_buffer) - _end;
+  if (length < accepted)
+  {
+    accepted = length;
+  }
+  memcpy(_buffer + _end, data, accepted);
+  _end += accepted;
+  return accepted;
+}
+
+bool Ccsds_Deframer::next(Ccsds_Packet_View &view)
+{
+  // Remove the packet that was returned by the last call
+  consume(_emitted_length);
+  _emitted_length = 0;
+
+  while (_end - _start >= CCSDS_PRIMARY_HEADER_LENGTH)
+  {
+    Ccsds_Packet_View candidate(_buffer + _start, _end - _start, _layout);
+
+    // Reject headers that can't belong to our packets without waiting for their data
+    uint32_t packet_length = candidate.get_packet_length();
+    if (candidate.get_version() != 0 || !candidate.has_secondary_header() || packet_length > sizeof(_buffer))
+    {
+      consume(1);
+      _statistics.skipped_bytes++;
+      continue;
+    }
+
+    // Wait for the rest of the packet
+    if (packet_length > static_cast<uint32_t>(_end - _start))
+    {
+      return false;
+    }
+
+    // Header looked fine but the checksum didn't match, so this wasn't a packet start
+    if (!candidate.is_valid())
+    {
+      consume(1);
+      _statistics.skipped_bytes++;
+      continue;
+    }
+
+    view = Ccsds_Packet_View(_buffer + _start, packet_length, _layout);
+    _emitted_length = packet_length;
+    _statistics.packets++;
+    return true;
+  }
+  return false;
+}
+
+uint32_t Ccsds_Deframer::feed(const uint8_t *data, size_t length, void (*packet_function)(const Ccsds_Packet_View &))
+{
+  uint32_t packets = 0;
+  Ccsds_Packet_View view;
+  while (length > 0)
+  {
+    size_t accepted = push(data, length);
+    data += accepted;
+    length -= accepted;
+
+    while (next(view))
+    {
+      packet_function(view);
+      packets++;
+    }
+  }
+  return packets;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
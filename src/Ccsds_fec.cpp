@@ -0,0 +1,138 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_fec.h"
+
+Ccsds_Fec::Ccsds_Fec(const Config &config) : _reed_solomon(config.parity_symbols)
+{
+  _interleave_depth = config.interleave_depth == 0 ? 1 : config.interleave_depth;
+  _statistics = {0, 0, 0, 0};
+}
+
+uint8_t Ccsds_Fec::get_codeword_data_length(uint16_t packet_length, uint8_t codeword) const
+{
+  if (codeword >= packet_length)
+  {
+    return 0;
+  }
+  return (packet_length - codeword + _interleave_depth - 1) / _interleave_depth;
+}
+
+uint16_t Ccsds_Fec::get_parity_index(uint16_t packet_length, uint8_t codeword, uint8_t symbol) const
+{
+  // Continue the interleaving pattern of the packet bytes, so frame byte p always belongs to codeword p % depth
+  uint8_t offset = (codeword + _interleave_depth - packet_length % _interleave_depth) % _interleave_depth;
+  return packet_length + symbol * _interleave_depth + offset;
+}
+
+uint16_t Ccsds_Fec::get_max_packet_length(uint16_t frame_size) const
+{
+  uint16_t codeword_limit = (255 - _reed_solomon.get_parity_symbols()) * _interleave_depth;
+  if (frame_size <= get_overhead())
+  {
+    return 0;
+  }
+  uint16_t frame_limit = frame_size - get_overhead();
+  return frame_limit < codeword_limit ? frame_limit : codeword_limit;
+}
+
+uint16_t Ccsds_Fec::encode(const uint8_t *packet, uint16_t packet_length, uint8_t *frame, uint16_t frame_size) const
+{
+  if (packet_length == 0 || packet_length > get_max_packet_length(frame_size))
+  {
+    return 0;
+  }
+  if (frame != packet)
+  {
+    memmove(frame, packet, packet_length);
+  }
+
+  uint8_t parity_symbols = _reed_solomon.get_parity_symbols();
+  uint8_t data[255];
+  uint8_t parity[REED_SOLOMON_MAX_PARITY_SYMBOLS];
+  for (uint8_t codeword = 0; codeword < _interleave_depth; codeword++)
+  {
+    // Gather the packet bytes of this codeword
+    uint8_t data_length = get_codeword_data_length(packet_length, codeword);
+    for (uint8_t i = 0; i < data_length; i++)
+    {
+      data[i] = frame[codeword + i * _interleave_depth];
+    }
+
+    // Packets shorter than the interleave depth leave some codewords without data, their parity is just padding
+    if (data_length == 0)
+    {
+      memset(parity, 0, parity_symbols);
+    }
+    else
+    {
+      _reed_solomon.encode(data, data_length, parity);
+    }
+
+    // Interleave the parity symbols after the packet
+    for (uint8_t j = 0; j < parity_symbols; j++)
+    {
+      frame[get_parity_index(packet_length, codeword, j)] = parity[j];
+    }
+  }
+  return packet_length + get_overhead();
+}
+
+int16_t Ccsds_Fec::decode(uint8_t *frame, uint16_t frame_length, uint16_t &packet_length)
+{
+  packet_length = 0;
+  _statistics.frames++;
+  if (frame_length <= get_overhead() || frame_length - get_overhead() > get_max_packet_length(frame_length))
+  {
+    _statistics.uncorrectable_frames++;
+    return -1;
+  }
+  uint16_t data_length_total = frame_length - get_overhead();
+
+  uint8_t parity_symbols = _reed_solomon.get_parity_symbols();
+  uint8_t codeword_buffer[255];
+  int16_t corrected = 0;
+  for (uint8_t codeword = 0; codeword < _interleave_depth; codeword++)
+  {
+    // Gather the codeword. Codewords without packet bytes have nothing to correct
+    uint8_t data_length = get_codeword_data_length(data_length_total, codeword);
+    if (data_length == 0)
+    {
+      continue;
+    }
+    for (uint8_t i = 0; i < data_length; i++)
+    {
+      codeword_buffer[i] = frame[codeword + i * _interleave_depth];
+    }
+    for (uint8_t j = 0; j < parity_symbols; j++)
+    {
+      codeword_buffer[data_length + j] = frame[get_parity_index(data_length_total, codeword, j)];
+    }
+
+    int16_t result = _reed_solomon.decode(codeword_buffer, data_length + parity_symbols);
+    if (result < 0)
+    {
+      _statistics.uncorrectable_frames++;
+      return -1;
+    }
+    if (result == 0)
+    {
+      continue;
+    }
+    corrected += result;
+
+    // Write the corrected packet bytes back, the parity isn't needed anymore
+    for (uint8_t i = 0; i < data_length; i++)
+    {
+      frame[codeword + i * _interleave_depth] = codeword_buffer[i];
+    }
+  }
+
+  if (corrected > 0)
+  {
+    _statistics.corrected_frames++;
+    _statistics.corrected_symbols += corrected;
+  }
+  packet_length = data_length_total;
+  return corrected;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,154 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_link_statistics.h"
+
+// Sequence counts are 14 bits
+const uint16_t SEQUENCE_COUNT_MASK = 0x3FFF;
+// Forward jumps shorter than half of the sequence count range are gaps, longer ones are old packets
+const uint16_t SEQUENCE_COUNT_HALF_RANGE = 0x2000;
+// Number of previous sequence counts remembered for duplicate and reorder detection
+const uint8_t RECEIVED_WINDOW_LENGTH = 32;
+
+Ccsds_Link_Statistics::Ccsds_Link_Statistics()
+{
+  reset();
+}
+
+void Ccsds_Link_Statistics::reset()
+{
+  _tracker_count = 0;
+}
+
+const Ccsds_Apid_Statistics *Ccsds_Link_Statistics::get(uint16_t apid) const
+{
+  for (uint8_t i = 0; i < _tracker_count; i++)
+  {
+    if (_trackers[i].statistics.apid == apid)
+    {
+      return &_trackers[i].statistics;
+    }
+  }
+  return nullptr;
+}
+
+bool Ccsds_Link_Statistics::update(uint16_t apid, uint16_t sequence_count)
+{
+  sequence_count &= SEQUENCE_COUNT_MASK;
+
+  // Find the tracker of this APID
+  Tracker *tracker = nullptr;
+  for (uint8_t i = 0; i < _tracker_count; i++)
+  {
+    if (_trackers[i].statistics.apid == apid)
+    {
+      tracker = &_trackers[i];
+      break;
+    }
+  }
+
+  // First packet of a new APID
+  if (tracker == nullptr)
+  {
+    if (_tracker_count >= CCSDS_LINK_STATISTICS_MAX_APIDS)
+    {
+      return false;
+    }
+    tracker = &_trackers[_tracker_count++];
+    tracker->statistics = {};
+    tracker->statistics.apid = apid;
+    tracker->statistics.last_sequence_count = sequence_count;
+    tracker->statistics.received = 1;
+    tracker->statistics.expected = 1;
+    tracker->received_window = 1;
+    tracker->expected_window = 1;
+    return true;
+  }
+
+  Ccsds_Apid_Statistics &statistics = tracker->statistics;
+  uint16_t forward = (sequence_count - statistics.last_sequence_count) & SEQUENCE_COUNT_MASK;
+
+  if (forward == 0)
+  {
+    statistics.duplicates++;
+  }
+  else if (forward < SEQUENCE_COUNT_HALF_RANGE)
+  {
+    // Newer packet, anything skipped is counted as lost until it arrives
+    uint16_t gap = forward - 1;
+    if (gap > 0)
+    {
+      statistics.lost += gap;
+      statistics.gaps++;
+      if (gap > statistics.max_gap)
+      {
+        statistics.max_gap = gap;
+      }
+    }
+    statistics.expected += forward;
+    statistics.received++;
+    statistics.last_sequence_count = sequence_count;
+    tracker->received_window = forward < RECEIVED_WINDOW_LENGTH ? (tracker->received_window << forward) | 1 : 1;
+    tracker->expected_window = forward < RECEIVED_WINDOW_LENGTH ? (tracker->expected_window << forward) | ((static_cast<uint32_t>(1) << forward) - 1) : 0xFFFFFFFF;
+  }
+  else
+  {
+    uint16_t backward = (statistics.last_sequence_count - sequence_count) & SEQUENCE_COUNT_MASK;
+    if (backward < RECEIVED_WINDOW_LENGTH)
+    {
+      // Older packet that is still in the window
+      uint32_t bit = static_cast<uint32_t>(1) << backward;
+      if (tracker->received_window & bit)
+      {
+        statistics.duplicates++;
+      }
+      else if (tracker->expected_window & bit)
+      {
+        // Arrived late, so it isn't lost after all
+        tracker->received_window |= bit;
+        statistics.reordered++;
+        statistics.received++;
+        if (statistics.lost > 0)
+        {
+          statistics.lost--;
+        }
+      }
+      else
+      {
+        // Older than the first packet seen or the last resync, so it was never counted as lost.
+        // Counted like a resync, but the newer packets stay the reference
+        tracker->received_window |= bit;
+        tracker->expected_window |= bit;
+        statistics.resyncs++;
+        statistics.received++;
+        statistics.expected++;
+      }
+    }
+    else
+    {
+      // Jumped too far back, the sender most likely restarted counting
+      statistics.resyncs++;
+      statistics.received++;
+      statistics.expected++;
+      statistics.last_sequence_count = sequence_count;
+      tracker->received_window = 1;
+      tracker->expected_window = 1;
+    }
+  }
+  return true;
+}
+
+float Ccsds_Link_Statistics::get_loss_ratio(const Ccsds_Apid_Statistics &statistics)
+{
+  if (statistics.expected == 0)
+  {
+    return 0;
+  }
+  return static_cast<float>(statistics.lost) / statistics.expected;
+}
+
+bool Ccsds_Link_Statistics::append(Ccsds_Packet_Builder &builder, const Ccsds_Apid_Statistics &statistics)
+{
+  return Ccsds_Apid_Statistics_Layout::append(builder, statistics.apid, statistics.last_sequence_count, statistics.received, statistics.expected, statistics.lost,
+                                              statistics.gaps, statistics.max_gap, statistics.duplicates, statistics.reordered, statistics.resyncs);
+}
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -3,27 +3,7 @@
 
 uint16_t calculate_crc_16_ccitt(const uint8_t *data, uint16_t length)
 {
-  uint16_t crc = 0xFFFF; // Initial value
-
-  for (uint16_t i = 0; i < length; i++)
-  {
-    crc ^= data[i]; // XOR with current byte
-
-    for (uint8_t j = 0; j < 8; j++)
-    {
-      if (crc & 0x0001) // If LSB is 1
-      {
-        crc >>= 1;     // Right shift by 1
-        crc ^= 0x8408; // XOR with polynomial 0x8408
-      }
-      else
-      {
-        crc >>= 1; // Right shift by 1
-      }
-    }
-  }
-
-  return crc;
+  return Crc16::Ccitt_Reflected<>::calculate(data, length);
 }
 
 void add_crc_16_cciit_to_ccsds_packet(uint8_t *&ccsds_packet, uint16_t ccsds_packet_length)
@@ -50,7 +30,7 @@ bool check_crc_16_cciit_of_ccsds_packet(uint8_t *ccsds_packet, uint16_t &ccsds_p
   }
 }
 
-byte *create_ccsds_primary_header(uint16_t apid, uint16_t sequence_count, uint16_t data_length)
+void write_ccsds_primary_header(uint8_t *buffer, uint16_t apid, uint16_t sequence_count, uint16_t data_length, Ccsds_Sequence_Flags sequence_flags)
 {
   // Packet version number - 3 bits total
   byte PACKET_VERSION_NUMBER = 0;
@@ -65,48 +45,125 @@ byte *create_ccsds_primary_header(uint16_t apid, uint16_t sequence_count, uint16
   int packet_identification_field = (PACKET_TYPE << 12) | (SECONDARY_HEADER_FLAG << 11) | apid_binary;
 
   // Packet Sequence Control - 16 bits total
-  // Sequence flags (Always 11, as we are sending a single undivided packet) - 2 bits
+  // Sequence flags (11 for a single undivided packet, 01 first, 00 continuation, 10 last segment) - 2 bits
   // Packet Sequence Count (Packet index)- 14 bits
-  byte PACKET_SEQUENCE_FLAG = 3;                       // binary 11 is 3 in decimal
+  byte PACKET_SEQUENCE_FLAG = static_cast<uint8_t>(sequence_flags) & 0x03;
   int packet_sequence_count = sequence_count & 0x3FFF; // keep only 14 bits
   int packet_sequence_control = (PACKET_SEQUENCE_FLAG << 14) | packet_sequence_count;
 
   // Packet data length - 16 bits total
   // 16-bit field contains a length count that equals one fewer than the length of the data field
-  byte *primary_header = new byte[6];
-  primary_header[0] = (PACKET_VERSION_NUMBER << 5) | ((packet_identification_field >> 8) & 0x1F);
-  primary_header[1] = packet_identification_field & 0xFF;
-  primary_header[2] = (packet_sequence_control >> 8) & 0xFF;
-  primary_header[3] = packet_sequence_control & 0xFF;
-  primary_header[4] = (data_length >> 8) & 0xFF;
-  primary_header[5] = data_length & 0xFF;
-
-  return primary_header;
+  buffer[0] = (PACKET_VERSION_NUMBER << 5) | ((packet_identification_field >> 8) & 0x1F);
+  buffer[1] = packet_identification_field & 0xFF;
+  buffer[2] = (packet_sequence_control >> 8) & 0xFF;
+  buffer[3] = packet_sequence_control & 0xFF;
+  buffer[4] = (data_length >> 8) & 0xFF;
+  buffer[5] = data_length & 0xFF;
 }
 
-byte *create_ccsds_secondary_header(uint32_t gps_epoch_time, uint16_t subseconds)
+void write_ccsds_secondary_header(uint8_t *buffer, uint32_t gps_epoch_time, uint16_t subseconds)
 {
   // GPS epoch time - 4 bytes
   // Subseconds - 2 bytes
+  buffer[0] = (gps_epoch_time >> 24) & 0xFF;
+  buffer[1] = (gps_epoch_time >> 16) & 0xFF;
+  buffer[2] = (gps_epoch_time >> 8) & 0xFF;
+  buffer[3] = gps_epoch_time & 0xFF;
+  buffer[4] = (subseconds >> 8) & 0xFF;
+  buffer[5] = subseconds & 0xFF;
+}
+
+Ccsds_Packet_Builder::Ccsds_Packet_Builder(uint8_t *buffer, uint16_t buffer_size)
+{
+  _buffer = buffer;
+  _buffer_size = buffer_size;
+  _length = CCSDS_TELEMETRY_HEADER_LENGTH;
+  _overflow = true; // Nothing can be appended before begin() is called
+  _apid = 0;
+  _sequence_count = 0;
+  _sequence_flags = Ccsds_Sequence_Flags::Unsegmented;
+}
 
-  // Create the secondary header
-  byte *secondary_header = new byte[6];
-  secondary_header[0] = (gps_epoch_time >> 24) & 0xFF;
-  secondary_header[1] = (gps_epoch_time >> 16) & 0xFF;
-  secondary_header[2] = (gps_epoch_time >> 8) & 0xFF;
-  secondary_header[3] = gps_epoch_time & 0xFF;
-  secondary_header[4] = (subseconds >> 8) & 0xFF;
-  secondary_header[5] = subseconds & 0xFF;
+bool Ccsds_Packet_Builder::begin(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds)
+{
+  _length = CCSDS_TELEMETRY_HEADER_LENGTH;
+  _apid = apid;
+  _sequence_count = sequence_count;
+  _sequence_flags = Ccsds_Sequence_Flags::Unsegmented;
+
+  // Headers and checksum must always fit
+  _overflow = _buffer == nullptr || _buffer_size < CCSDS_TELEMETRY_HEADER_LENGTH + CCSDS_CRC_LENGTH;
+  if (_overflow)
+  {
+    return false;
+  }
 
-  return secondary_header;
+  // The primary header is written in finish(), when the data length is known
+  write_ccsds_secondary_header(_buffer + CCSDS_PRIMARY_HEADER_LENGTH, gps_epoch_time, subseconds);
+  return true;
 }
 
-byte *create_ccsds_telemetry_packet(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, String data, uint16_t &ccsds_packet_length)
+uint16_t Ccsds_Packet_Builder::get_remaining_length() const
+{
+  if (_overflow)
+  {
+    return 0;
+  }
+  return _buffer_size - _length - CCSDS_CRC_LENGTH;
+}
+
+uint8_t *Ccsds_Packet_Builder::reserve(uint16_t length)
 {
-  // Convert each value in a string to corresponding data type and convert to byte array
-  byte packet_data[244]; // LoRa max packet length is 256 bytes, but taking out 12 bytes for primary and secondary headers (256-12=244)
+  if (length > get_remaining_length())
+  {
+    _overflow = true;
+    return nullptr;
+  }
+  uint8_t *reserved = _buffer + _length;
+  _length += length;
+  return reserved;
+}
+
+bool Ccsds_Packet_Builder::append(const uint8_t *data, uint16_t length)
+{
+  uint8_t *destination = reserve(length);
+  if (destination == nullptr)
+  {
+    return false;
+  }
+  memcpy(destination, data, length);
+  return true;
+}
+
+uint16_t Ccsds_Packet_Builder::finish()
+{
+  if (_overflow)
+  {
+    return 0;
+  }
+  write_ccsds_primary_header(_buffer, _apid, _sequence_count, get_data_length(), _sequence_flags);
+
+  // Add checksum
+  uint16_t ccsds_packet_length = _length + CCSDS_CRC_LENGTH;
+  add_crc_16_cciit_to_ccsds_packet(_buffer, ccsds_packet_length);
+
+  return ccsds_packet_length;
+}
 
-  uint16_t packet_data_length = 0;
+uint16_t build_ccsds_telemetry_packet(uint8_t *buffer, uint16_t buffer_size, uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const uint8_t *data, uint16_t data_length)
+{
+  Ccsds_Packet_Builder builder(buffer, buffer_size);
+  builder.begin(apid, sequence_count, gps_epoch_time, subseconds);
+  builder.append(data, data_length);
+  return builder.finish();
+}
+
+uint16_t build_ccsds_telemetry_packet(uint8_t *buffer, uint16_t buffer_size, uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const String &data)
+{
+  Ccsds_Packet_Builder builder(buffer, buffer_size);
+  builder.begin(apid, sequence_count, gps_epoch_time, subseconds);
+
+  // Convert each value in a string to corresponding data type and write it directly into the packet
   Converter converter;
 
   uint16_t start = 0;
@@ -132,65 +189,114 @@ byte *create_ccsds_telemetry_packet(uint16_t apid, uint16_t sequence_count, uint
     }
     else // String
     {
-      value += "\n"; // Add newline character to end of string
-      for (int i = 0; i < value.length(); i++)
-      {
-        packet_data[packet_data_length++] = value[i]; // Add each character to packet
-      }
+      builder.append(reinterpret_cast<const uint8_t *>(value.c_str()), value.length());
+      builder.append(reinterpret_cast<const uint8_t *>("\n"), 1); // Add newline character to end of string
       // Move on to next value
       start = end + 1;
       continue;
     }
 
     // Add value to packet as byte array
-    for (int i = 3; i >= 0; i--)
+    uint8_t *destination = builder.reserve(4);
+    if (destination != nullptr)
     {
-      packet_data[packet_data_length++] = converter.b[i]; // MSB first
+      for (int i = 3; i >= 0; i--)
+      {
+        *destination++ = converter.b[i]; // MSB first
+      }
     }
     start = end + 1;
   }
 
-  // Create full packet
-  byte *primary_header = create_ccsds_primary_header(apid, sequence_count, packet_data_length);
-  byte *secondary_header = create_ccsds_secondary_header(gps_epoch_time, subseconds);
-
-  byte *packet = new byte[12 + packet_data_length + 2]; // Additional 2 bytes for checksum that will be added later
-  
-  // Add primary header, secondary header, and data to packet
-  memcpy(packet, primary_header, 6);
-  memcpy(packet + 6, secondary_header, 6);
-  memcpy(packet + 12, packet_data, packet_data_length);
+  return builder.finish();
+}
 
-  ccsds_packet_length = 12 + packet_data_length + 2;
+byte *create_ccsds_primary_header(uint16_t apid, uint16_t sequence_count, uint16_t data_length)
+{
+  byte *primary_header = new byte[CCSDS_PRIMARY_HEADER_LENGTH];
+  write_ccsds_primary_header(primary_header, apid, sequence_count, data_length);
+  return primary_header;
+}
 
-  // Add checksum
-  add_crc_16_cciit_to_ccsds_packet(packet, ccsds_packet_length);
+byte *create_ccsds_secondary_header(uint32_t gps_epoch_time, uint16_t subseconds)
+{
+  byte *secondary_header = new byte[CCSDS_SECONDARY_HEADER_LENGTH];
+  write_ccsds_secondary_header(secondary_header, gps_epoch_time, subseconds);
+  return secondary_header;
+}
 
-  // Free memory
-  delete[] primary_header;   // VERY IMPORTANT, otherwise a significant memory leak will occur
-  delete[] secondary_header; // VERY IMPORTANT, otherwise a significant memory leak will occur
+byte *create_ccsds_telemetry_packet(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, String data, uint16_t &ccsds_packet_length)
+{
+  // Build the packet on the stack and only allocate the exact returned size
+  byte packet_buffer[CCSDS_MAX_PACKET_LENGTH];
+  ccsds_packet_length = build_ccsds_telemetry_packet(packet_buffer, CCSDS_MAX_PACKET_LENGTH, apid, sequence_count, gps_epoch_time, subseconds, data);
+  if (ccsds_packet_length == 0)
+  {
+    return nullptr;
+  }
 
+  byte *packet = new byte[ccsds_packet_length];
+  memcpy(packet, packet_buffer, ccsds_packet_length);
   return packet;
 }
 
-void parse_ccsds_telemetry(byte *packet, uint16_t &apid, uint16_t &sequence_count, uint32_t &gps_epoch_time, uint16_t &subseconds, byte *&ccsds_data, uint16_t &data_length)
+bool Ccsds_Packet_View::is_valid() const
 {
-  // Read primary header (6 bytes)
-  byte packet_version_number = (packet[0] >> 5) & 0x07;
-  byte packet_identification_field[2] = {static_cast<byte>(packet[0] & 0x1F), packet[1]};
-  byte packet_sequence_control[2] = {packet[2], packet[3]};
-  byte packet_data_length[2] = {packet[4], packet[5]};
+  // The primary header is needed to know the declared length
+  if (_frame == nullptr || _frame_length < CCSDS_PRIMARY_HEADER_LENGTH)
+  {
+    return false;
+  }
+
+  // Declared length must fit in the received frame
+  uint32_t packet_length = get_packet_length();
+  if (packet_length > _frame_length)
+  {
+    return false;
+  }
 
-  // Read secondary header (6 bytes)
-  byte gps_epoch_time_bytes[4] = {packet[6], packet[7], packet[8], packet[9]};
-  byte subseconds_bytes[2] = {packet[10], packet[11]};
+  // Check CRC of the declared packet
+  uint16_t crc_index = packet_length - CCSDS_CRC_LENGTH;
+  uint16_t crc = calculate_crc_16_ccitt(_frame, crc_index);
+  return _frame[crc_index] == ((crc >> 8) & 0xFF) && _frame[crc_index + 1] == (crc & 0xFF);
+}
+
+uint16_t Ccsds_Packet_View::get_header_length() const
+{
+  if (_layout == Layout::Telecommand)
+  {
+    return CCSDS_PRIMARY_HEADER_LENGTH + 2; // Packet id
+  }
+  return CCSDS_TELEMETRY_HEADER_LENGTH;
+}
+
+uint32_t Ccsds_Packet_View::get_gps_epoch_time() const
+{
+  const uint8_t *secondary_header = _frame + CCSDS_PRIMARY_HEADER_LENGTH;
+  return (static_cast<uint32_t>(secondary_header[0]) << 24) | (static_cast<uint32_t>(secondary_header[1]) << 16) | (secondary_header[2] << 8) | secondary_header[3];
+}
+
+uint16_t Ccsds_Packet_View::get_subseconds() const
+{
+  const uint8_t *secondary_header = _frame + CCSDS_PRIMARY_HEADER_LENGTH;
+  return (secondary_header[4] << 8) | secondary_header[5];
+}
+
+uint16_t Ccsds_Packet_View::get_packet_id() const
+{
+  const uint8_t *secondary_header = _frame + CCSDS_PRIMARY_HEADER_LENGTH;
+  return (secondary_header[0] << 8) | secondary_header[1];
+}
 
-  // Convert bytes to integers
-  apid = ((packet_identification_field[0] & 0x07) << 8) | packet_identification_field[1];
-  sequence_count = ((packet_sequence_control[0] << 8) | packet_sequence_control[1]) & 0x3FFF;
-  data_length = (packet_data_length[0] << 8) | packet_data_length[1];
-  gps_epoch_time = (gps_epoch_time_bytes[0] << 24) | (gps_epoch_time_bytes[1] << 16) | (gps_epoch_time_bytes[2] << 8) | gps_epoch_time_bytes[3];
-  subseconds = (subseconds_bytes[0] << 8) | subseconds_bytes[1];
+void parse_ccsds_telemetry(byte *packet, uint16_t &apid, uint16_t &sequence_count, uint32_t &gps_epoch_time, uint16_t &subseconds, byte *&ccsds_data, uint16_t &data_length)
+{
+  // The frame length is unknown here, so the header is trusted
+  Ccsds_Packet_View view(packet, CCSDS_TELEMETRY_HEADER_LENGTH, Ccsds_Packet_View::Layout::Telemetry);
+  apid = view.get_apid();
+  sequence_count = view.get_sequence_count();
+  data_length = view.get_data_length();
+  gps_epoch_time = view.get_gps_epoch_time();
+  subseconds = view.get_subseconds();
 
   // Read data
   // Data starts at byte 12 until the end of the packet
@@ -200,25 +306,17 @@ void parse_ccsds_telemetry(byte *packet, uint16_t &apid, uint16_t &sequence_coun
     return;
   }
   ccsds_data = new byte[data_length];
-  memcpy(ccsds_data, packet + 12, data_length);
+  memcpy(ccsds_data, view.get_data(), data_length);
 }
 
 void parse_ccsds_telecommand(byte *packet, uint16_t &apid, uint16_t &sequence_count, uint16_t &packet_id, byte *&ccsds_data, uint16_t &data_length)
 {
-  // Read primary header (6 bytes)
-  byte packet_version_number = (packet[0] >> 5) & 0x07;
-  byte packet_identification_field[2] = {static_cast<byte>(packet[0] & 0x1F), packet[1]};
-  byte packet_sequence_control[2] = {packet[2], packet[3]};
-  byte packet_data_length[2] = {packet[4], packet[5]};
-
-  // Read packet id (2 bytes)
-  byte packet_id_bytes[2] = {packet[6], packet[7]};
-
-  // Convert bytes to integers
-  apid = ((packet_identification_field[0] & 0x07) << 8) | packet_identification_field[1];
-  sequence_count = ((packet_sequence_control[0] << 8) | packet_sequence_control[1]) & 0x3FFF;
-  data_length = (packet_data_length[0] << 8) | packet_data_length[1];
-  packet_id = (packet_id_bytes[0] << 8) | packet_id_bytes[1];
+  // The frame length is unknown here, so the header is trusted
+  Ccsds_Packet_View view(packet, CCSDS_PRIMARY_HEADER_LENGTH + 2, Ccsds_Packet_View::Layout::Telecommand);
+  apid = view.get_apid();
+  sequence_count = view.get_sequence_count();
+  data_length = view.get_data_length();
+  packet_id = view.get_packet_id();
 
   // Read data
   // Data starts at byte 8 until the end of the packet
@@ -228,7 +326,7 @@ void parse_ccsds_telecommand(byte *packet, uint16_t &apid, uint16_t &sequence_co
     return;
   }
   ccsds_data = new byte[data_length];
-  memcpy(ccsds_data, packet + 8, data_length);
+  memcpy(ccsds_data, view.get_data(), data_length);
 }
 
 void extract_ccsds_data_values(byte *ccsds_data, Converter *data_values, String data_format)
@@ -236,48 +334,264 @@ void extract_ccsds_data_values(byte *ccsds_data, Converter *data_values, String
   // The data_format is a string that contains the data types of each value in the packet
   // The data types are stored in the string in the same order as the values in the packet
   // Example: "float,uint8,uint16,uint32"
+  // The data length is unknown here, so the plan is trusted
+  Ccsds_Decode_Plan plan;
+  if (compile_ccsds_decode_plan(data_format, plan))
+  {
+    extract_ccsds_data_values(ccsds_data, plan.data_length, data_values, plan);
+    return;
+  }
+
+  // Unknown data types (like " uint8" with a space) have always been skipped without reading any bytes,
+  // the following values still go to their own index. Decode one value at a time to keep that
   uint16_t start = 0;
   uint16_t value_index = 0;
   uint16_t data_index = 0;
   while (start < data_format.length())
   {
-    // Find next comma
     int end = data_format.indexOf(',', start);
     if (end == -1)
     {
       end = data_format.length();
     }
+    if (compile_ccsds_decode_plan(data_format.substring(start, end), plan) && plan.field_count == 1)
+    {
+      extract_ccsds_data_values(ccsds_data + data_index, plan.data_length, data_values + value_index, plan);
+      data_index += plan.data_length;
+    }
+    start = end + 1;
+    value_index++;
+  }
+}
 
-    // Get value
-    String value = data_format.substring(start, end);
+uint8_t get_ccsds_field_size(Ccsds_Field_Type type)
+{
+  switch (type)
+  {
+  case Ccsds_Field_Type::Uint8:
+  case Ccsds_Field_Type::Int8:
+    return 1;
+  case Ccsds_Field_Type::Uint16:
+  case Ccsds_Field_Type::Int16:
+    return 2;
+  case Ccsds_Field_Type::Float:
+  case Ccsds_Field_Type::Uint32:
+  case Ccsds_Field_Type::Int32:
+    return 4;
+  case Ccsds_Field_Type::Int64:
+  case Ccsds_Field_Type::Uint64:
+  case Ccsds_Field_Type::Double:
+    return 8;
+  }
+  return 0;
+}
 
-    // Read value from packet (MSB first)
-    if (value == "float") // Float (4 bytes)
+bool is_ccsds_field_signed(Ccsds_Field_Type type)
+{
+  return type == Ccsds_Field_Type::Int8 || type == Ccsds_Field_Type::Int16 || type == Ccsds_Field_Type::Int32 || type == Ccsds_Field_Type::Int64;
+}
+
+bool compile_ccsds_decode_plan(const String &data_format, Ccsds_Decode_Plan &plan)
+{
+  // Data type names in the format String
+  struct Field_Name
+  {
+    const char *name;
+    Ccsds_Field_Type type;
+  };
+  static const Field_Name FIELD_NAMES[] = {
+      {"float", Ccsds_Field_Type::Float},
+      {"uint8", Ccsds_Field_Type::Uint8},
+      {"uint16", Ccsds_Field_Type::Uint16},
+      {"uint32", Ccsds_Field_Type::Uint32},
+      {"uint64", Ccsds_Field_Type::Uint64},
+      {"int8", Ccsds_Field_Type::Int8},
+      {"int16", Ccsds_Field_Type::Int16},
+      {"int32", Ccsds_Field_Type::Int32},
+      {"int64", Ccsds_Field_Type::Int64},
+#if __SIZEOF_DOUBLE__ == 8 // Platforms with a 4 byte double can't hold the value
+      {"double", Ccsds_Field_Type::Double},
+#endif
+  };
+
+  plan.field_count = 0;
+  plan.scale_count = 0;
+  plan.data_length = 0;
+
+  const char *format = data_format.c_str();
+  uint16_t format_length = data_format.length();
+  uint16_t start = 0;
+  while (start < format_length)
+  {
+    // Find next comma and the optional fixed-point scale
+    uint16_t end = start;
+    uint16_t name_end = 0;
+    while (end < format_length && format[end] != ',')
     {
-      data_values[value_index].b[3] = ccsds_data[data_index++];
-      data_values[value_index].b[2] = ccsds_data[data_index++];
-      data_values[value_index].b[1] = ccsds_data[data_index++];
-      data_values[value_index].b[0] = ccsds_data[data_index++];
+      if (format[end] == '*' && name_end == 0)
+      {
+        name_end = end;
+      }
+      end++;
     }
-    else if (value == "uint8") // Unsigned 8-bit integer (1 byte)
+    if (name_end == 0)
     {
-      data_values[value_index].b[0] = ccsds_data[data_index++];
+      name_end = end;
     }
-    else if (value == "uint16") // Unsigned 16-bit integer (2 bytes)
+
+    // Find the data type, comparing in place without creating a substring
+    const Field_Name *found = nullptr;
+    for (const Field_Name &field_name : FIELD_NAMES)
     {
-      data_values[value_index].b[1] = ccsds_data[data_index++];
-      data_values[value_index].b[0] = ccsds_data[data_index++];
+      if (strlen(field_name.name) == static_cast<size_t>(name_end - start) && strncmp(format + start, field_name.name, name_end - start) == 0)
+      {
+        found = &field_name;
+        break;
+      }
     }
-    else if (value == "uint32") // Unsigned 32-bit integer (4 bytes)
+    if (found == nullptr || plan.field_count >= CCSDS_DECODE_PLAN_MAX_FIELDS)
     {
-      data_values[value_index].b[3] = ccsds_data[data_index++];
-      data_values[value_index].b[2] = ccsds_data[data_index++];
-      data_values[value_index].b[1] = ccsds_data[data_index++];
-      data_values[value_index].b[0] = ccsds_data[data_index++];
+      return false;
+    }
+
+    Ccsds_Decode_Plan::Field &field = plan.fields[plan.field_count];
+    field.type = found->type;
+    field.scale_index = CCSDS_DECODE_PLAN_NO_SCALE;
+    field.offset = plan.data_length;
+
+    // Fixed-point scale, only for integers
+    if (name_end != end)
+    {
+      if (found->type == Ccsds_Field_Type::Float || found->type == Ccsds_Field_Type::Double)
+      {
+        return false;
+      }
+      char *scale_end;
+      double scale = strtod(format + name_end + 1, &scale_end);
+      if (scale_end != format + end || scale == 0)
+      {
+        return false;
+      }
+
+      // Reuse the scale if another field already has it
+      for (uint8_t i = 0; i < plan.scale_count; i++)
+      {
+        if (plan.scales[i] == scale)
+        {
+          field.scale_index = i;
+          break;
+        }
+      }
+      if (field.scale_index == CCSDS_DECODE_PLAN_NO_SCALE)
+      {
+        if (plan.scale_count >= CCSDS_DECODE_PLAN_MAX_SCALES)
+        {
+          return false;
+        }
+        plan.scales[plan.scale_count] = scale;
+        field.scale_index = plan.scale_count++;
+      }
     }
+
+    plan.field_count++;
+    plan.data_length += get_ccsds_field_size(found->type);
     start = end + 1;
-    value_index++;
   }
+  return true;
+}
+
+uint64_t get_ccsds_field_raw_value(const Converter &data_value, const Ccsds_Decode_Plan &plan, uint8_t index)
+{
+  const Ccsds_Decode_Plan::Field &field = plan.fields[index];
+  uint8_t size = get_ccsds_field_size(field.type);
+  uint64_t mask = size >= 8 ? UINT64_MAX : (static_cast<uint64_t>(1) << (size * 8)) - 1;
+
+  if (field.scale_index != CCSDS_DECODE_PLAN_NO_SCALE)
+  {
+    // Round the scaled value to the nearest integer and limit it to the field range
+    double scaled = data_value.d / plan.scales[field.scale_index];
+    scaled = scaled < 0 ? scaled - 0.5 : scaled + 0.5;
+    double max = is_ccsds_field_signed(field.type) ? static_cast<double>(mask >> 1) : static_cast<double>(mask);
+    double min = is_ccsds_field_signed(field.type) ? -max - 1 : 0;
+    if (scaled >= max)
+    {
+      return is_ccsds_field_signed(field.type) ? mask >> 1 : mask;
+    }
+    if (scaled <= min)
+    {
+      return is_ccsds_field_signed(field.type) ? (mask >> 1) + 1 : 0;
+    }
+    return static_cast<uint64_t>(static_cast<int64_t>(scaled)) & mask;
+  }
+  if (field.type == Ccsds_Field_Type::Float)
+  {
+    return data_value.i32;
+  }
+  return data_value.i64 & mask;
+}
+
+void set_ccsds_field_raw_value(Converter &data_value, uint64_t raw_value, const Ccsds_Decode_Plan &plan, uint8_t index)
+{
+  const Ccsds_Decode_Plan::Field &field = plan.fields[index];
+  uint8_t size = get_ccsds_field_size(field.type);
+
+  // Sign extend negative values to 64 bits, so all signed members of the union read them correctly
+  if (is_ccsds_field_signed(field.type) && size < 8 && ((raw_value >> (size * 8 - 1)) & 0x01))
+  {
+    raw_value |= UINT64_MAX << (size * 8);
+  }
+
+  if (field.scale_index != CCSDS_DECODE_PLAN_NO_SCALE)
+  {
+    double value = is_ccsds_field_signed(field.type) ? static_cast<double>(static_cast<int64_t>(raw_value)) : static_cast<double>(raw_value);
+    data_value.d = value * plan.scales[field.scale_index];
+    return;
+  }
+  data_value.i64 = raw_value;
+}
+
+bool extract_ccsds_data_values(const uint8_t *ccsds_data, uint16_t data_length, Converter *data_values, const Ccsds_Decode_Plan &plan)
+{
+  if (ccsds_data == nullptr || data_length < plan.data_length)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < plan.field_count; i++)
+  {
+    // Read value from packet (MSB first)
+    const uint8_t *value = ccsds_data + plan.fields[i].offset;
+    uint8_t size = get_ccsds_field_size(plan.fields[i].type);
+    uint64_t raw_value = 0;
+    for (uint8_t byte_index = 0; byte_index < size; byte_index++)
+    {
+      raw_value = (raw_value << 8) | value[byte_index];
+    }
+    set_ccsds_field_raw_value(data_values[i], raw_value, plan, i);
+  }
+  return true;
+}
+
+uint16_t write_ccsds_data_values(uint8_t *ccsds_data, uint16_t data_length, const Converter *data_values, const Ccsds_Decode_Plan &plan)
+{
+  if (ccsds_data == nullptr || data_length < plan.data_length)
+  {
+    return 0;
+  }
+
+  for (uint8_t i = 0; i < plan.field_count; i++)
+  {
+    // Write value to packet (MSB first)
+    uint8_t *value = ccsds_data + plan.fields[i].offset;
+    uint8_t size = get_ccsds_field_size(plan.fields[i].type);
+    uint64_t raw_value = get_ccsds_field_raw_value(data_values[i], plan, i);
+    for (int8_t byte_index = size - 1; byte_index >= 0; byte_index--)
+    {
+      value[byte_index] = raw_value & 0xFF;
+      raw_value >>= 8;
+    }
+  }
+  return plan.data_length;
 }
 
 void read_position_from_ccsds_telemetry(uint8_t *&ccsds_data, float &latitude, float &longitude, float &altitude)
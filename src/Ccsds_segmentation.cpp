@@ -0,0 +1,217 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_segmentation.h"
+
+Ccsds_Segmenter::Ccsds_Segmenter()
+{
+  _data = nullptr;
+  _length = 0;
+  _offset = 0;
+  _started = false;
+  _apid = 0;
+  _sequence_count = 0;
+  _gps_epoch_time = 0;
+  _subseconds = 0;
+  _max_packet_length = CCSDS_MAX_FRAME_LENGTH;
+}
+
+bool Ccsds_Segmenter::begin(uint16_t apid, uint16_t sequence_count, uint32_t gps_epoch_time, uint16_t subseconds, const uint8_t *data, uint32_t length, uint16_t max_packet_length)
+{
+  _started = false;
+  // Every segment must be able to carry at least one byte
+  if (data == nullptr || length == 0 || max_packet_length <= CCSDS_TELEMETRY_HEADER_LENGTH + CCSDS_CRC_LENGTH)
+  {
+    return false;
+  }
+  _data = data;
+  _length = length;
+  _offset = 0;
+  _apid = apid;
+  _sequence_count = sequence_count & 0x3FFF;
+  _gps_epoch_time = gps_epoch_time;
+  _subseconds = subseconds;
+  _max_packet_length = max_packet_length;
+  _started = true;
+  return true;
+}
+
+uint16_t Ccsds_Segmenter::next(uint8_t *buffer, uint16_t buffer_size)
+{
+  if (is_done())
+  {
+    return 0;
+  }
+
+  uint16_t max_data_length = _max_packet_length - CCSDS_TELEMETRY_HEADER_LENGTH - CCSDS_CRC_LENGTH;
+  uint32_t remaining = _length - _offset;
+  uint16_t data_length = remaining < max_data_length ? remaining : max_data_length;
+
+  // Pick the flags based on where this segment is in the block
+  Ccsds_Sequence_Flags sequence_flags;
+  bool is_first = _offset == 0;
+  bool is_last = remaining <= max_data_length;
+  if (is_first && is_last)
+  {
+    sequence_flags = Ccsds_Sequence_Flags::Unsegmented;
+  }
+  else if (is_first)
+  {
+    sequence_flags = Ccsds_Sequence_Flags::First;
+  }
+  else if (is_last)
+  {
+    sequence_flags = Ccsds_Sequence_Flags::Last;
+  }
+  else
+  {
+    sequence_flags = Ccsds_Sequence_Flags::Continuation;
+  }
+
+  Ccsds_Packet_Builder builder(buffer, buffer_size);
+  builder.begin(_apid, _sequence_count, _gps_epoch_time, _subseconds);
+  builder.set_sequence_flags(sequence_flags);
+  builder.append(_data + _offset, data_length);
+  uint16_t packet_length = builder.finish();
+  if (packet_length == 0)
+  {
+    return 0;
+  }
+
+  _offset += data_length;
+  _sequence_count = (_sequence_count + 1) & 0x3FFF;
+  return packet_length;
+}
+
+Ccsds_Reassembler::Ccsds_Reassembler(unsigned long timeout)
+{
+  _timeout = timeout;
+  _completed_slot = nullptr;
+  _statistics = {0, 0, 0, 0, 0};
+  for (Slot &slot : _slots)
+  {
+    slot.in_use = false;
+  }
+}
+
+Ccsds_Reassembler::Slot *Ccsds_Reassembler::find_slot(uint16_t apid)
+{
+  for (Slot &slot : _slots)
+  {
+    if (slot.in_use && slot.apid == apid)
+    {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+void Ccsds_Reassembler::check_timeouts(unsigned long now)
+{
+  for (Slot &slot : _slots)
+  {
+    if (slot.in_use && &slot != _completed_slot && now - slot.last_update_time >= _timeout)
+    {
+      slot.in_use = false;
+      _statistics.timed_out++;
+    }
+  }
+}
+
+Ccsds_Reassembler::Result Ccsds_Reassembler::add(const Ccsds_Packet_View &view, const uint8_t *&data, uint32_t &length, unsigned long now)
+{
+  // Free the block returned by the previous call
+  if (_completed_slot != nullptr)
+  {
+    _completed_slot->in_use = false;
+    _completed_slot = nullptr;
+  }
+  check_timeouts(now);
+
+  uint16_t apid = view.get_apid();
+  uint16_t sequence_count = view.get_sequence_count();
+  uint16_t data_length = view.get_data_length();
+  Ccsds_Sequence_Flags sequence_flags = static_cast<Ccsds_Sequence_Flags>(view.get_sequence_flags());
+  Slot *slot = find_slot(apid);
+
+  if (sequence_flags == Ccsds_Sequence_Flags::Unsegmented || sequence_flags == Ccsds_Sequence_Flags::First)
+  {
+    // A new block interrupts any unfinished one with the same APID
+    if (slot != nullptr)
+    {
+      slot->in_use = false;
+      _statistics.sequence_gaps++;
+    }
+
+    if (sequence_flags == Ccsds_Sequence_Flags::Unsegmented)
+    {
+      data = view.get_data();
+      length = data_length;
+      _statistics.completed++;
+      return Result::Complete;
+    }
+
+    // Take a free slot
+    slot = nullptr;
+    for (Slot &free_slot : _slots)
+    {
+      if (!free_slot.in_use)
+      {
+        slot = &free_slot;
+        break;
+      }
+    }
+    if (slot == nullptr)
+    {
+      _statistics.no_free_slot++;
+      return Result::Dropped;
+    }
+    if (data_length > CCSDS_REASSEMBLY_MAX_LENGTH)
+    {
+      _statistics.overflows++;
+      return Result::Dropped;
+    }
+    slot->in_use = true;
+    slot->apid = apid;
+    slot->length = 0;
+  }
+  else
+  {
+    // Continuation or last segment must follow the previous one directly
+    if (slot == nullptr)
+    {
+      _statistics.sequence_gaps++;
+      return Result::Dropped;
+    }
+    if (sequence_count != slot->next_sequence_count)
+    {
+      slot->in_use = false;
+      _statistics.sequence_gaps++;
+      return Result::Dropped;
+    }
+    if (slot->length + data_length > CCSDS_REASSEMBLY_MAX_LENGTH)
+    {
+      slot->in_use = false;
+      _statistics.overflows++;
+      return Result::Dropped;
+    }
+  }
+
+  if (data_length > 0)
+  {
+    memcpy(slot->data + slot->length, view.get_data(), data_length);
+  }
+  slot->length += data_length;
+  slot->next_sequence_count = (sequence_count + 1) & 0x3FFF;
+  slot->last_update_time = now;
+
+  if (sequence_flags == Ccsds_Sequence_Flags::Last)
+  {
+    data = slot->data;
+    length = slot->length;
+    _completed_slot = slot;
+    _statistics.completed++;
+    return Result::Complete;
+  }
+  return Result::Incomplete;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
@@ -0,0 +1,91 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Ccsds_telecommand_dispatcher.h"
+
+Ccsds_Telecommand_Dispatcher::Ccsds_Telecommand_Dispatcher()
+{
+  _handler_count = 0;
+  for (Entry &entry : _entries)
+  {
+    entry.handler = nullptr;
+  }
+}
+
+uint8_t Ccsds_Telecommand_Dispatcher::get_hash(uint16_t apid, uint16_t packet_id)
+{
+  // Multiplicative hash of the combined key
+  uint32_t key = (static_cast<uint32_t>(apid) << 16) | packet_id;
+  return ((key * 2654435761UL) >> 16) & (CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE - 1);
+}
+
+Ccsds_Telecommand_Dispatcher::Entry *Ccsds_Telecommand_Dispatcher::find_entry(uint16_t apid, uint16_t packet_id)
+{
+  // Linear probing until the command or a free slot is found. The table is never more than half full
+  uint8_t index = get_hash(apid, packet_id);
+  while (_entries[index].handler != nullptr)
+  {
+    if (_entries[index].apid == apid && _entries[index].packet_id == packet_id)
+    {
+      return &_entries[index];
+    }
+    index = (index + 1) & (CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE - 1);
+  }
+  return &_entries[index];
+}
+
+bool Ccsds_Telecommand_Dispatcher::register_handler(uint16_t apid, uint16_t packet_id, Handler handler, unsigned long min_interval)
+{
+  if (handler == nullptr)
+  {
+    return false;
+  }
+
+  Entry *entry = find_entry(apid, packet_id);
+  if (entry->handler == nullptr)
+  {
+    // Keep the load at most half so lookups stay short
+    if (_handler_count >= CCSDS_TELECOMMAND_DISPATCHER_TABLE_SIZE / 2)
+    {
+      return false;
+    }
+    _handler_count++;
+  }
+
+  entry->handler = handler;
+  entry->apid = apid;
+  entry->packet_id = packet_id;
+  entry->min_interval = min_interval;
+  entry->last_call_time = 0;
+  entry->called = false;
+  return true;
+}
+
+Ccsds_Telecommand_Dispatcher::Result Ccsds_Telecommand_Dispatcher::dispatch(const Ccsds_Packet_View &telecommand, unsigned long now)
+{
+  Entry *entry = find_entry(telecommand.get_apid(), telecommand.get_packet_id());
+  if (entry->handler == nullptr)
+  {
+    return Result::Unknown_Command;
+  }
+
+  if (entry->called && now - entry->last_call_time < entry->min_interval)
+  {
+    return Result::Rate_Limited;
+  }
+  entry->called = true;
+  entry->last_call_time = now;
+
+  entry->handler(telecommand);
+  return Result::Handled;
+}
+
+Ccsds_Telecommand_Dispatcher::Result Ccsds_Telecommand_Dispatcher::dispatch(const uint8_t *frame, uint16_t frame_length, unsigned long now)
+{
+  Ccsds_Packet_View telecommand(frame, frame_length, Ccsds_Packet_View::Layout::Telecommand);
+  if (!telecommand.is_valid())
+  {
+    return Result::Invalid_Packet;
+  }
+  return dispatch(telecommand, now);
+}
+
+#endif // CCSDS_PACKETS_ENABLE
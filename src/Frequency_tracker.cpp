@@ -0,0 +1,77 @@
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include "Frequency_tracker.h"
+
+// 2 kHz per packet and 20 kHz in total cover the drift of typical crystals without a TCXO
+const Frequency_Tracker::Config Frequency_Tracker::DEFAULT_CONFIG = {0.3, 0.02, -10, 0.002, 0.02};
+
+Frequency_Tracker::Frequency_Tracker(const Config &config, double centre_frequency)
+{
+  _config = config;
+  reset(centre_frequency);
+}
+
+void Frequency_Tracker::reset(double centre_frequency)
+{
+  _centre_frequency = centre_frequency;
+  memset(&_state, 0, sizeof(_state));
+  _state.frequency = centre_frequency;
+  _has_measurement = false;
+  _last_update_time = 0;
+}
+
+static double limit(double value, double min, double max)
+{
+  return value < min ? min : (value > max ? max : value);
+}
+
+double Frequency_Tracker::update(double frequency_error, float snr, uint32_t now)
+{
+  _state.last_error = frequency_error;
+  if (snr < _config.min_snr)
+  {
+    _state.rejected++;
+    return _state.frequency;
+  }
+  _state.accepted++;
+
+  // Carrier offset measured by this packet
+  double measured_offset = _state.frequency - frequency_error / 1000000.0 - _centre_frequency;
+
+  if (!_has_measurement)
+  {
+    _state.offset = measured_offset;
+    _state.drift = 0;
+    _has_measurement = true;
+  }
+  else
+  {
+    // Packets can be close together or far apart, limit the time step so the drift estimate stays stable
+    double time_step = limit((now - _last_update_time) / 1000.0, 0.1, 10);
+    double predicted_offset = _state.offset + _state.drift * time_step;
+    double residual = measured_offset - predicted_offset;
+    _state.offset = predicted_offset + _config.alpha * residual;
+    _state.drift += _config.beta * residual / time_step;
+  }
+  _last_update_time = now;
+
+  // Offset bounds, the drift estimate is reset when the offset hits them
+  if (_state.offset > _config.max_offset || _state.offset < -_config.max_offset)
+  {
+    _state.offset = limit(_state.offset, -_config.max_offset, _config.max_offset);
+    _state.drift = 0;
+    _state.limited++;
+  }
+
+  // Move the receiver towards the estimate, at most max_step at a time
+  double target = _centre_frequency + _state.offset;
+  double step = target - _state.frequency;
+  if (step > _config.max_step || step < -_config.max_step)
+  {
+    step = limit(step, -_config.max_step, _config.max_step);
+    _state.limited++;
+  }
+  _state.frequency += step;
+  return _state.frequency;
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE
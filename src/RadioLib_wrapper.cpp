@@ -2,21 +2,6 @@
 
 #include "RadioLib_wrapper.h"
 
-// Flags for radio interrupt functions
-volatile bool action_done = true;
-
-/*
-If compiling for ESP boards, specify that these function are used within interrupt routine
-and such should be stored in the RAM and not the flash memory
-*/
-#if defined(ESP8266) || defined(ESP32)
-ICACHE_RAM_ATTR
-#endif
-void RadioLib_interrupts::set_action_done_flag(void)
-{
-    action_done = true;
-}
-
 template <typename T>
 RadioLib_Wrapper<T>::RadioLib_Wrapper(void (*error_function)(String), int check_sum_length, String sensor_name) : Sensor_Wrapper(sensor_name, error_function)
 {
@@ -24,6 +9,14 @@ RadioLib_Wrapper<T>::RadioLib_Wrapper(void (*error_function)(String), int check_
     // Save the name of the radio type and set error function
     _action_status_code = RADIOLIB_ERR_NONE;
     _action_type = Action_Type::Standby;
+    clear_tx_queue();
+}
+
+template <typename T>
+RadioLib_Wrapper<T>::~RadioLib_Wrapper()
+{
+    RadioLib_interrupts::detach(_interrupt_slot);
+    delete _radio_config;
 }
 
 template <typename T>
@@ -31,6 +24,9 @@ bool RadioLib_Wrapper<T>::begin(Radio_Config radio_config)
 {
     // Set the used frequency to the inital one
     _used_frequency = radio_config.frequency;
+    // A zero offset gain would never follow the carrier, so it means the tracking config was left out
+    _frequency_tracker = Frequency_Tracker(radio_config.frequency_tracking.alpha > 0 ? radio_config.frequency_tracking : Frequency_Tracker::DEFAULT_CONFIG, radio_config.frequency);
+    reset_statistics();
     if (radio_config.frequency_correction)
     {
         _frequency_correction_enabled = true;
@@ -57,8 +53,17 @@ bool RadioLib_Wrapper<T>::begin(Radio_Config radio_config)
         error("Initialization failed with status code: " + String(_action_status_code));
         return false;
     }
-    // Set interrupt behaviour
-    radio.setPacketReceivedAction(RadioLib_interrupts::set_action_done_flag);
+    // Set interrupt behaviour, each radio has its own interrupt function and flag
+    if (_interrupt_slot < 0)
+    {
+        _interrupt_slot = RadioLib_interrupts::attach(&_action_flag);
+    }
+    if (_interrupt_slot < 0)
+    {
+        error("No free interrupt slot, increase RADIO_INTERRUPTS_MAX_RADIOS");
+        return false;
+    }
+    radio.setPacketReceivedAction(RadioLib_interrupts::get_interrupt_function(_interrupt_slot));
     _action_type = Action_Type::Standby;
 
     if (configure_radio(radio_config) == false)
@@ -67,11 +72,176 @@ bool RadioLib_Wrapper<T>::begin(Radio_Config radio_config)
         return false;
     }
 
+    // Keep the config for recovering from timeouts. Radio_Config has const members, so it can't be assigned
+    delete _radio_config;
+    _radio_config = new Radio_Config(radio_config);
+
     // Set that radio has been initialized
     set_initialized(true);
     return true;
 }
 
+// Count a value in a fixed bucket histogram
+static void add_to_histogram(uint32_t *buckets, float value, float start, float width)
+{
+    int bucket = (value - start) / width;
+    if (value < start || bucket < 0)
+    {
+        bucket = 0;
+    }
+    if (bucket >= RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS)
+    {
+        bucket = RADIOLIB_WRAPPER_HISTOGRAM_BUCKETS - 1;
+    }
+    buckets[bucket]++;
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::begin_statistics_update()
+{
+    _statistics_sequence = _statistics_sequence + 1;
+    __sync_synchronize();
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::end_statistics_update()
+{
+    __sync_synchronize();
+    _statistics_sequence = _statistics_sequence + 1;
+}
+
+template <typename T>
+uint32_t RadioLib_Wrapper<T>::get_time_on_air(size_t length) const
+{
+    // Not configured yet
+    if (_modulation.spreading == 0)
+    {
+        return 0;
+    }
+    return Radio_Time_On_Air::get_time_on_air(_modulation.family, _modulation.spreading, _modulation.signal_bw, _modulation.coding_rate, length);
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::record_transmit(size_t length, bool success)
+{
+    if (!success)
+    {
+        begin_statistics_update();
+        _statistics.transmit_failures++;
+        end_statistics_update();
+        return;
+    }
+
+    uint32_t time_on_air = get_time_on_air(length) / 1000;
+    begin_statistics_update();
+    _statistics.transmitted++;
+    _statistics.transmit_time_on_air += time_on_air;
+    end_statistics_update();
+
+    // Start the watchdog
+    _action_start_time = millis();
+    _action_timeout = time_on_air + time_on_air / 2 + RADIOLIB_WRAPPER_TX_TIMEOUT_MARGIN;
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::record_receive(size_t length, float rssi, float snr, float frequency_error)
+{
+    if (length == 0)
+    {
+        begin_statistics_update();
+        _statistics.receive_failures++;
+        end_statistics_update();
+        return;
+    }
+
+    uint32_t time_on_air = get_time_on_air(length) / 1000;
+    begin_statistics_update();
+    _statistics.received++;
+    _statistics.receive_time_on_air += time_on_air;
+    add_to_histogram(_statistics.rssi_histogram, rssi, RADIOLIB_WRAPPER_RSSI_HISTOGRAM_START, RADIOLIB_WRAPPER_RSSI_HISTOGRAM_WIDTH);
+    add_to_histogram(_statistics.snr_histogram, snr, RADIOLIB_WRAPPER_SNR_HISTOGRAM_START, RADIOLIB_WRAPPER_SNR_HISTOGRAM_WIDTH);
+    add_to_histogram(_statistics.frequency_error_histogram, frequency_error, RADIOLIB_WRAPPER_FREQUENCY_ERROR_HISTOGRAM_START, RADIOLIB_WRAPPER_FREQUENCY_ERROR_HISTOGRAM_WIDTH);
+    end_statistics_update();
+}
+
+template <typename T>
+typename RadioLib_Wrapper<T>::Radio_Statistics RadioLib_Wrapper<T>::get_statistics() const
+{
+    // Sequence lock: retry if an update started or finished while copying
+    Radio_Statistics copy;
+    uint32_t sequence;
+    do
+    {
+        sequence = _statistics_sequence;
+        __sync_synchronize();
+        copy = _statistics;
+        __sync_synchronize();
+    } while ((sequence & 0x01) || sequence != _statistics_sequence);
+    return copy;
+}
+
+template <typename T>
+float RadioLib_Wrapper<T>::get_transmit_duty_cycle(const Radio_Statistics &statistics, uint32_t now)
+{
+    uint32_t elapsed = now - statistics.start_time;
+    if (elapsed == 0)
+    {
+        return 0;
+    }
+    return static_cast<float>(statistics.transmit_time_on_air) / elapsed;
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::reset_statistics()
+{
+    begin_statistics_update();
+    memset(&_statistics, 0, sizeof(_statistics));
+    _statistics.start_time = millis();
+    end_statistics_update();
+}
+
+template <typename T>
+bool RadioLib_Wrapper<T>::check_action_timeout()
+{
+    // Receiving waits for a packet for an unknown time, so only transmissions can time out
+    if (_action_flag.done || _action_type != Action_Type::Transmit || _action_timeout == 0)
+    {
+        return false;
+    }
+    if (millis() - _action_start_time < _action_timeout)
+    {
+        return false;
+    }
+
+    begin_statistics_update();
+    _statistics.timeouts++;
+    end_statistics_update();
+    error("Transmit done interrupt missed. Recovering radio");
+
+    // Stop the transmission and clear the interrupt flags in the radio
+    radio.standby();
+    radio.finishTransmit();
+    if (_radio_config != nullptr && _radio_config->reconfigure_on_timeout)
+    {
+        // configure_radio() sets the values from begin(), go back to the corrected frequency and the
+        // modulation set with set_modulation(), so the other side can still hear this radio
+        Modulation modulation = _modulation;
+        if (configure_radio(*_radio_config))
+        {
+            radio.setFrequency(_used_frequency);
+            radio.setSpreadingFactor(modulation.spreading);
+            radio.setBandwidth(modulation.signal_bw);
+            radio.setCodingRate(modulation.coding_rate);
+            _modulation = modulation;
+        }
+    }
+
+    _action_timeout = 0;
+    _action_type = Action_Type::Standby;
+    _action_flag.done = true;
+    return true;
+}
+
 template <typename T>
 bool RadioLib_Wrapper<T>::configure_radio(Radio_Config radio_config)
 {
@@ -105,6 +275,22 @@ bool RadioLib_Wrapper<T>::configure_radio(Radio_Config radio_config)
         return false;
     };
 
+    _modulation.spreading = radio_config.spreading;
+    _modulation.signal_bw = radio_config.signal_bw;
+    _modulation.coding_rate = radio_config.coding_rate;
+    if (radio_config.family == Radio_Config::Chip_Family::Sx126x)
+    {
+        _modulation.family = Radio_Time_On_Air::Chip_Family::Sx126x;
+    }
+    else if (radio_config.family == Radio_Config::Chip_Family::Sx128x)
+    {
+        _modulation.family = Radio_Time_On_Air::Chip_Family::Sx128x;
+    }
+    else
+    {
+        _modulation.family = Radio_Time_On_Air::Chip_Family::Sx127x;
+    }
+
     if (radio.setSyncWord(radio_config.sync_word) == RADIOLIB_ERR_INVALID_SYNC_WORD)
     {
         error("Sync word is invalid: " + String(radio_config.sync_word));
@@ -132,6 +318,58 @@ bool RadioLib_Wrapper<T>::configure_radio(Radio_Config radio_config)
     return true;
 }
 
+template <typename T>
+bool RadioLib_Wrapper<T>::set_modulation(int spreading, float signal_bw, int coding_rate)
+{
+    if (!get_initialized())
+    {
+        return false;
+    }
+    check_action_timeout();
+
+    // Changing the modulation would corrupt the frame being sent
+    if (!_action_flag.done && _action_type == Action_Type::Transmit)
+    {
+        return false;
+    }
+
+    // Modulation can only be changed in standby
+    radio.standby();
+    int16_t spreading_state = radio.setSpreadingFactor(spreading);
+    int16_t bandwidth_state = spreading_state == RADIOLIB_ERR_NONE ? radio.setBandwidth(signal_bw) : RADIOLIB_ERR_NONE;
+    int16_t coding_rate_state = bandwidth_state == RADIOLIB_ERR_NONE ? radio.setCodingRate(coding_rate) : RADIOLIB_ERR_NONE;
+    bool success = spreading_state == RADIOLIB_ERR_NONE && bandwidth_state == RADIOLIB_ERR_NONE && coding_rate_state == RADIOLIB_ERR_NONE;
+    if (!success)
+    {
+        error("Modulation is invalid: SF" + String(spreading) + " BW" + String(signal_bw) + " CR" + String(coding_rate));
+        // Go back to the values that were set before
+        if (_modulation.spreading != 0)
+        {
+            radio.setSpreadingFactor(_modulation.spreading);
+            radio.setBandwidth(_modulation.signal_bw);
+            radio.setCodingRate(_modulation.coding_rate);
+        }
+    }
+    else
+    {
+        _modulation.spreading = spreading;
+        _modulation.signal_bw = signal_bw;
+        _modulation.coding_rate = coding_rate;
+    }
+
+    // Receiving was stopped by standby, so start it again
+    if (_action_type == Action_Type::Receive)
+    {
+        restart_receive();
+    }
+    else
+    {
+        _action_type = Action_Type::Standby;
+        _action_flag.done = true;
+    }
+    return success;
+}
+
 template <typename T>
 bool RadioLib_Wrapper<T>::setBoostedRx()
 {
@@ -201,22 +439,23 @@ bool RadioLib_Wrapper<T>::transmit(String msg)
     {
         return false;
     }
+    check_action_timeout();
 
     // if radio did something that is not sending data before and it hasn't timedout. Time it out
-    if (!action_done && _action_type != Action_Type::Transmit)
+    if (!_action_flag.done && _action_type != Action_Type::Transmit)
     {
-        action_done = true;
+        _action_flag.done = true;
     }
 
     // If already transmitting, don't continue
-    if (action_done == false)
+    if (_action_flag.done == false)
     {
         return false;
     }
     else
     {
         // else reset flag
-        action_done = false;
+        _action_flag.done = false;
     }
 
     // Clean up from the previous time
@@ -224,6 +463,7 @@ bool RadioLib_Wrapper<T>::transmit(String msg)
 
     // Start transmitting
     _action_status_code = radio.startTransmit(msg);
+    record_transmit(msg.length(), _action_status_code == RADIOLIB_ERR_NONE);
 
     // If transmit failed, print error
     if (_action_status_code != RADIOLIB_ERR_NONE)
@@ -244,22 +484,23 @@ bool RadioLib_Wrapper<T>::transmit_bytes(uint8_t* bytes, size_t length)
   {
     return false;
   }
+  check_action_timeout();
 
   // if radio did something that is not sending data before and it hasn't timed out. Time it out
-  if (!action_done && _action_type != Action_Type::Transmit)
+  if (!_action_flag.done && _action_type != Action_Type::Transmit)
   {
-    action_done = true;
+    _action_flag.done = true;
   }
 
   // If already transmitting, don't continue
-  if (action_done == false)
+  if (_action_flag.done == false)
   {
     return false;
   }
   else
   {
     // else reset flag
-    action_done = false;
+    _action_flag.done = false;
   }
 
   // Clean up from the previous time
@@ -267,6 +508,7 @@ bool RadioLib_Wrapper<T>::transmit_bytes(uint8_t* bytes, size_t length)
 
   // Start transmitting
   _action_status_code = radio.startTransmit(bytes, length);
+  record_transmit(length, _action_status_code == RADIOLIB_ERR_NONE);
 
   // If transmit failed, print error
   if (_action_status_code != RADIOLIB_ERR_NONE)
@@ -280,6 +522,290 @@ bool RadioLib_Wrapper<T>::transmit_bytes(uint8_t* bytes, size_t length)
   return true;
 }
 
+template <typename T>
+bool RadioLib_Wrapper<T>::queue_transmit_bytes(const uint8_t *bytes, size_t length, Transmit_Priority priority)
+{
+#if RADIOLIB_WRAPPER_TX_QUEUE_LENGTH == 0
+    (void)bytes;
+    (void)priority;
+    error("Transmit queue is disabled, set RADIOLIB_WRAPPER_TX_QUEUE_LENGTH to use it. Frame length: " + String(length));
+    return false;
+#else
+    if (length > RADIOLIB_WRAPPER_TX_QUEUE_FRAME_LENGTH)
+    {
+        error("Frame too long for the transmit queue: " + String(length));
+        return false;
+    }
+
+    int free_index = -1;
+    if (_tx_queue_count < RADIOLIB_WRAPPER_TX_QUEUE_LENGTH)
+    {
+        for (int i = 0; i < RADIOLIB_WRAPPER_TX_QUEUE_LENGTH; i++)
+        {
+            if (!_tx_queue[i].used)
+            {
+                free_index = i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        // Queue is full, make space by dropping the newest frame with the lowest priority if it is less important
+        for (int i = 0; i < RADIOLIB_WRAPPER_TX_QUEUE_LENGTH; i++)
+        {
+            if (_tx_queue[i].priority >= priority)
+            {
+                continue;
+            }
+            if (free_index == -1 || _tx_queue[i].priority < _tx_queue[free_index].priority ||
+                (_tx_queue[i].priority == _tx_queue[free_index].priority && _tx_queue[i].order > _tx_queue[free_index].order))
+            {
+                free_index = i;
+            }
+        }
+        if (free_index == -1)
+        {
+            _tx_queue_statistics.overflows++;
+            return false;
+        }
+        _tx_queue[free_index].used = false;
+        _tx_queue_count--;
+        _tx_queue_statistics.evicted++;
+    }
+
+    Tx_Queue_Slot &slot = _tx_queue[free_index];
+    memcpy(slot.data, bytes, length);
+    slot.length = length;
+    slot.priority = priority;
+    slot.order = _tx_queue_order++;
+    slot.used = true;
+    _tx_queue_count++;
+    _tx_queue_statistics.queued++;
+    return true;
+#endif
+}
+
+template <typename T>
+bool RadioLib_Wrapper<T>::queue_transmit(const String &msg, Transmit_Priority priority)
+{
+    return queue_transmit_bytes(reinterpret_cast<const uint8_t *>(msg.c_str()), msg.length(), priority);
+}
+
+#if RADIOLIB_WRAPPER_TX_QUEUE_LENGTH > 0
+template <typename T>
+int RadioLib_Wrapper<T>::get_next_tx_queue_index()
+{
+    int next_index = -1;
+    for (int i = 0; i < RADIOLIB_WRAPPER_TX_QUEUE_LENGTH; i++)
+    {
+        if (!_tx_queue[i].used)
+        {
+            continue;
+        }
+        // Highest priority first, oldest first within the same priority
+        if (next_index == -1 || _tx_queue[i].priority > _tx_queue[next_index].priority ||
+            (_tx_queue[i].priority == _tx_queue[next_index].priority && _tx_queue[i].order < _tx_queue[next_index].order))
+        {
+            next_index = i;
+        }
+    }
+    return next_index;
+}
+#endif
+
+template <typename T>
+bool RadioLib_Wrapper<T>::poll()
+{
+    if (!get_initialized())
+    {
+        return false;
+    }
+    check_action_timeout();
+
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH > 0
+    // Move a received frame out of the radio FIFO before anything else, so the next one can't overwrite it
+    if (_rx_buffering_enabled && _action_flag.done && _action_type == Action_Type::Receive)
+    {
+        service_rx_ring();
+    }
+#endif
+
+    // Starting a transmission needs SPI, so it can't be done in the interrupt. Wait for the flag here instead
+    if (!_action_flag.done && _action_type == Action_Type::Transmit)
+    {
+        return false;
+    }
+    if (_tx_queue_count == 0)
+    {
+        // Go back to receiving after the last queued frame was sent
+        if (_rx_buffering_enabled && _action_type != Action_Type::Receive)
+        {
+            restart_receive();
+        }
+        return false;
+    }
+
+#if RADIOLIB_WRAPPER_TX_QUEUE_LENGTH > 0
+    // The radio isn't busy, so transmit only fails if the radio rejects the frame. Retrying won't help, so it is dropped
+    Tx_Queue_Slot &slot = _tx_queue[get_next_tx_queue_index()];
+    bool started = transmit_bytes(slot.data, slot.length);
+    if (started)
+    {
+        _tx_queue_statistics.transmitted++;
+    }
+    else
+    {
+        _tx_queue_statistics.failed++;
+    }
+    slot.used = false;
+    _tx_queue_count--;
+    return started;
+#else
+    return false;
+#endif
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::clear_tx_queue()
+{
+#if RADIOLIB_WRAPPER_TX_QUEUE_LENGTH > 0
+    for (Tx_Queue_Slot &slot : _tx_queue)
+    {
+        slot.used = false;
+    }
+#endif
+    _tx_queue_count = 0;
+}
+
+template <typename T>
+double RadioLib_Wrapper<T>::correct_frequency(double frequency_error, float snr)
+{
+    double new_freq = _frequency_tracker.update(frequency_error, snr);
+    if (new_freq != _used_frequency)
+    {
+        if (radio.setFrequency(new_freq) != RADIOLIB_ERR_INVALID_FREQUENCY)
+        {
+            _used_frequency = new_freq;
+        }
+        else
+        {
+            _frequency_tracker.set_tuned_frequency(_used_frequency);
+        }
+    }
+    return _used_frequency;
+}
+
+template <typename T>
+bool RadioLib_Wrapper<T>::start_receive_buffering()
+{
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH == 0
+    error("Receive ring is disabled, set RADIOLIB_WRAPPER_RX_RING_LENGTH to use it");
+    return false;
+#else
+    if (!get_initialized())
+    {
+        return false;
+    }
+    _rx_buffering_enabled = true;
+    if (_action_type == Action_Type::Transmit && !_action_flag.done)
+    {
+        // Receiving is started by poll() after the transmission is done
+        return true;
+    }
+    return restart_receive();
+#endif
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::stop_receive_buffering()
+{
+    _rx_buffering_enabled = false;
+}
+
+template <typename T>
+bool RadioLib_Wrapper<T>::restart_receive()
+{
+    _action_flag.done = false;
+    _action_type = Action_Type::Receive;
+    _action_status_code = radio.startReceive();
+    if (_action_status_code != RADIOLIB_ERR_NONE)
+    {
+        error("Starting receive failed with status code: " + String(_action_status_code));
+        return false;
+    }
+    return true;
+}
+
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH > 0
+template <typename T>
+void RadioLib_Wrapper<T>::service_rx_ring()
+{
+    uint32_t arrival_time = _action_flag.time;
+    uint16_t length = radio.getPacketLength();
+
+    // Drop the frame if there is no space, so the frames already waiting keep their order
+    if (_rx_ring_count >= RADIOLIB_WRAPPER_RX_RING_LENGTH || length > RADIOLIB_WRAPPER_RX_RING_FRAME_LENGTH)
+    {
+        _rx_ring_statistics.overflows++;
+        restart_receive();
+        return;
+    }
+
+    Rx_Ring_Slot &slot = _rx_ring[(_rx_ring_head + _rx_ring_count) % RADIOLIB_WRAPPER_RX_RING_LENGTH];
+    radio.standby();
+    _action_status_code = radio.readData(slot.data, length);
+    if (_action_status_code != RADIOLIB_ERR_NONE || length == 0)
+    {
+        _rx_ring_statistics.errors++;
+        record_receive(0, 0, 0, 0);
+        restart_receive();
+        return;
+    }
+
+    slot.length = length;
+    slot.metadata.rssi = radio.getRSSI();
+    slot.metadata.snr = radio.getSNR();
+    slot.metadata.frequency_error = radio.getFrequencyError();
+    slot.metadata.frequency = _used_frequency;
+    slot.metadata.timestamp = arrival_time;
+    record_receive(length, slot.metadata.rssi, slot.metadata.snr, slot.metadata.frequency_error);
+    if (_frequency_correction_enabled)
+    {
+        correct_frequency(slot.metadata.frequency_error, slot.metadata.snr);
+    }
+    _rx_ring_count++;
+    _rx_ring_statistics.received++;
+
+    restart_receive();
+}
+#endif
+
+template <typename T>
+bool RadioLib_Wrapper<T>::read_received_bytes(uint8_t *bytes, uint16_t size, uint16_t &data_length, Rx_Metadata &metadata)
+{
+#if RADIOLIB_WRAPPER_RX_RING_LENGTH == 0
+    (void)bytes;
+    (void)size;
+    (void)data_length;
+    (void)metadata;
+    return false;
+#else
+    if (_rx_ring_count == 0)
+    {
+        return false;
+    }
+
+    Rx_Ring_Slot &slot = _rx_ring[_rx_ring_head];
+    data_length = slot.length < size ? slot.length : size;
+    memcpy(bytes, slot.data, data_length);
+    metadata = slot.metadata;
+    _rx_ring_head = (_rx_ring_head + 1) % RADIOLIB_WRAPPER_RX_RING_LENGTH;
+    _rx_ring_count--;
+    return true;
+#endif
+}
+
 // Listen to messages over LoRa. Returns true if received successfully
 template <typename T>
 bool RadioLib_Wrapper<T>::receive(String &msg, float &rssi, float &snr, double &frequency)
@@ -288,16 +814,17 @@ bool RadioLib_Wrapper<T>::receive(String &msg, float &rssi, float &snr, double &
     {
         return false;
     }
+    check_action_timeout();
 
     // If already doing something, don't continue
-    if (action_done == false)
+    if (_action_flag.done == false)
     {
         return false;
     }
     else
     {
         // else reset flag
-        action_done = false;
+        _action_flag.done = false;
     }
     // Put into standby to try reading data
     radio.standby();
@@ -316,18 +843,12 @@ bool RadioLib_Wrapper<T>::receive(String &msg, float &rssi, float &snr, double &
         rssi = radio.getRSSI();
         snr = radio.getSNR();
         frequency = _used_frequency;
+        double frequency_error = radio.getFrequencyError();
+        record_receive(_action_status_code == RADIOLIB_ERR_NONE ? str.length() : 0, rssi, snr, frequency_error);
 
         if (_frequency_correction_enabled)
         {
-            // Frequency correction
-            double freq_error = radio.getFrequencyError() / 1000000.0;
-            double new_freq = _used_frequency - freq_error;
-            // Serial.println("Freq error: " + String(freq_error, 10) + " | Old freq: " + String(used_frequency, 10) + " | New freq: " + String(new_freq, 10));
-            if (radio.setFrequency(new_freq) != RADIOLIB_ERR_INVALID_FREQUENCY)
-            {
-                _used_frequency = new_freq;
-                frequency = new_freq;
-            }
+            frequency = correct_frequency(frequency_error, snr);
         }
     }
     // Restart receiving TODO add error check for start recieve
@@ -348,16 +869,17 @@ bool RadioLib_Wrapper<T>::receive_bytes(uint8_t *data, uint16_t &data_length, fl
   {
     return false;
   }
+  check_action_timeout();
 
   // If already doing something, don't continue
-  if (action_done == false)
+  if (_action_flag.done == false)
   {
     return false;
   }
   else
   {
     // else reset flag
-    action_done = false;
+    _action_flag.done = false;
   }
   // Put into standby to try reading data
   radio.standby();
@@ -376,17 +898,12 @@ bool RadioLib_Wrapper<T>::receive_bytes(uint8_t *data, uint16_t &data_length, fl
     rssi = radio.getRSSI();
     snr = radio.getSNR();
     frequency = _used_frequency;
+    double frequency_error = radio.getFrequencyError();
+    record_receive(_action_status_code == RADIOLIB_ERR_NONE ? data_length : 0, rssi, snr, frequency_error);
 
     if (_frequency_correction_enabled)
     {
-      // Frequency correction
-      double freq_error = radio.getFrequencyError() / 1000000.0;
-      double new_freq = _used_frequency - freq_error;
-      if (radio.setFrequency(new_freq) != RADIOLIB_ERR_INVALID_FREQUENCY)
-      {
-        _used_frequency = new_freq;
-        frequency = new_freq;
-      }
+      frequency = correct_frequency(frequency_error, snr);
     }
   }
   // Restart receiving TODO add error check for start recieve
@@ -401,107 +918,229 @@ bool RadioLib_Wrapper<T>::receive_bytes(uint8_t *data, uint16_t &data_length, fl
   return true;
 }
 
-// used for CRC16 checksum
 template <typename T>
-uint16_t RadioLib_Wrapper<T>::crc_xmodem_update(uint16_t crc, uint8_t data)
+uint16_t RadioLib_Wrapper<T>::calculate_CRC16_CCITT_checksum(const String &msg)
 {
-    int i;
-    crc = crc ^ ((uint16_t)data << 8);
-    for (i = 0; i < 8; i++)
-    {
-        if (crc & 0x8000)
-            crc = (crc << 1) ^ 0x1021;
-        else
-            crc <<= 1;
-    }
-    return crc;
+    return calculate_CRC16_CCITT_checksum(msg.c_str(), msg.length());
 }
 
 template <typename T>
-uint16_t RadioLib_Wrapper<T>::calculate_CRC16_CCITT_checksum(const String &msg)
+uint16_t RadioLib_Wrapper<T>::calculate_CRC16_CCITT_checksum(const char *msg, size_t length)
+{
+    return Crc16::Ccitt<>::calculate(reinterpret_cast<const uint8_t *>(msg), length);
+}
+
+template <typename T>
+size_t RadioLib_Wrapper<T>::get_checksum_start(const char *msg, size_t length)
 {
-    size_t i;
-    uint16_t crc;
-    uint8_t c;
+#if RADIOLIB_WRAPPER_LEGACY_CHECKSUM_PREFIX
+    // Only the first character is compared, like the original firmware. A lone "$" has nothing left to checksum
+    if (length >= 1 && msg[0] == '$')
+    {
+        return length >= 2 ? 2 : length;
+    }
+#else
+    if (length >= 2 && msg[0] == '$' && msg[1] == '$')
+    {
+        return 2;
+    }
+#endif
+    return 0;
+}
 
-    crc = 0xFFFF;
+// Write a value as lowercase hex text without leading zeros (same as String(value, HEX))
+static uint8_t write_hex(char *buffer, uint16_t value)
+{
+    const char DIGITS[] = "0123456789abcdef";
+    uint8_t digit_count = 1;
+    while (digit_count < 4 && (value >> (digit_count * 4)) != 0)
+    {
+        digit_count++;
+    }
+    for (uint8_t i = 0; i < digit_count; i++)
+    {
+        buffer[i] = DIGITS[(value >> ((digit_count - 1 - i) * 4)) & 0x0F];
+    }
+    return digit_count;
+}
 
-    // Calculate checksum
-    for (i = 0; i < msg.length(); i++)
+// Parse 1 to 4 hex digits. Returns false if any other character is found
+static bool parse_hex(const char *text, size_t length, uint16_t &value)
+{
+    if (length == 0 || length > 4)
     {
-        c = msg.charAt(i);
-        crc = crc_xmodem_update(crc, c);
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = text[i];
+        uint8_t digit;
+        if (c >= '0' && c <= '9')
+        {
+            digit = c - '0';
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            digit = c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            digit = c - 'A' + 10;
+        }
+        else
+        {
+            return false;
+        }
+        value = (value << 4) | digit;
     }
+    return true;
+}
 
-    return crc;
+static bool is_whitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
 }
 
 template <typename T>
-void RadioLib_Wrapper<T>::add_checksum(String &msg)
+size_t RadioLib_Wrapper<T>::add_checksum(char *msg, size_t length, size_t size, Checksum_Format format)
 {
-    int crc_index_start = 0;
-    if (msg.charAt(0) == '$' && msg.charAt(0) == '$')
+    size_t crc_index_start = get_checksum_start(msg, length);
+    uint16_t crc = calculate_CRC16_CCITT_checksum(msg + crc_index_start, length - crc_index_start);
+
+    if (format == Checksum_Format::Binary)
     {
-        crc_index_start = 2;
+        if (length + 2 > size)
+        {
+            return 0;
+        }
+        msg[length++] = (crc >> 8) & 0xFF;
+        msg[length++] = crc & 0xFF;
+        return length;
     }
 
-    msg += "*" + String(calculate_CRC16_CCITT_checksum(msg.substring(crc_index_start)), HEX) + '\n';
+    // "*" + up to 4 hex digits + "\n" + null terminator
+    if (length + 7 > size)
+    {
+        return 0;
+    }
+    msg[length++] = '*';
+    length += write_hex(msg + length, crc);
+    msg[length++] = '\n';
+    msg[length] = '\0';
+    return length;
 }
+
 template <typename T>
-bool RadioLib_Wrapper<T>::check_checksum(String &msg)
+bool RadioLib_Wrapper<T>::verify_checksum(const char *msg, size_t length, size_t &content_start, size_t &content_length, Checksum_Format format)
 {
-    msg.trim();
+    if (format == Checksum_Format::Binary)
+    {
+        size_t crc_index_start = get_checksum_start(msg, length);
+        if (length < crc_index_start + 2)
+        {
+            return false;
+        }
+        uint16_t provided_checksum = (static_cast<uint8_t>(msg[length - 2]) << 8) | static_cast<uint8_t>(msg[length - 1]);
+        if (calculate_CRC16_CCITT_checksum(msg + crc_index_start, length - 2 - crc_index_start) != provided_checksum)
+        {
+            return false;
+        }
+        content_start = crc_index_start;
+        content_length = length - 2 - crc_index_start;
+        return true;
+    }
 
-    if (msg.length() < 6)
+    // Ignore whitespace around the message, such as the line ending
+    size_t start = 0;
+    while (start < length && is_whitespace(msg[start]))
     {
-        return false;
+        start++;
     }
-    int crc_index_start = 0;
-    if (msg.charAt(0) == '$' && msg.charAt(0) == '$')
+    while (length > start && is_whitespace(msg[length - 1]))
     {
-        crc_index_start = 2;
+        length--;
     }
-
-    // checkfor outof bounds
-    int crc_index_end = 0;
-    int i_end = msg.length() - 6;
-    if (i_end < 0)
+    if (length - start < 6)
     {
-        i_end = 0;
+        return false;
     }
+    size_t crc_index_start = start + get_checksum_start(msg + start, length - start);
 
-    for (int i = msg.length(); i > i_end; i--)
+    // The checksum is at most 4 hex digits after the last "*"
+    size_t crc_index_end = 0;
+    for (size_t i = length - 1; i > start && i + 5 >= length; i--)
     {
-        // Serial.println(" i:" + String(i)); for debugging
-        if (msg.charAt(i) == '*')
+        if (msg[i] == '*')
         {
             crc_index_end = i;
             break;
         }
     }
-
     // no crc found
-    if (crc_index_end == 0)
+    if (crc_index_end == 0 || crc_index_end < crc_index_start)
     {
         return false;
     }
-    // Extract the provided checksum from the message
-    String provided_checksum = msg.substring(crc_index_end + 1, msg.length());
-    // Extract the original content of the message (excluding the checksum)
-    String original_msg = msg.substring(crc_index_start, crc_index_end);
 
-    String calculated_checksum = String(calculate_CRC16_CCITT_checksum(original_msg), HEX); // Calculate checksum from the original message
+    uint16_t provided_checksum;
+    if (!parse_hex(msg + crc_index_end + 1, length - crc_index_end - 1, provided_checksum))
+    {
+        return false;
+    }
+    if (calculate_CRC16_CCITT_checksum(msg + crc_index_start, crc_index_end - crc_index_start) != provided_checksum)
+    {
+        return false;
+    }
+    content_start = crc_index_start;
+    content_length = crc_index_end - crc_index_start;
+    return true;
+}
 
-    // Compare the calculated checksum with the provided checksum
-    if (calculated_checksum.equals(provided_checksum))
+template <typename T>
+bool RadioLib_Wrapper<T>::check_checksum(char *msg, size_t &length, Checksum_Format format)
+{
+    size_t content_start;
+    size_t content_length;
+    if (!verify_checksum(msg, length, content_start, content_length, format))
     {
-        msg = original_msg; // Remove the checksum from the original message
-        return true;        // Checksum verified
+        return false;
     }
-    else
+    // The checksum is removed, so there is always space for the null terminator
+    memmove(msg, msg + content_start, content_length);
+    msg[content_length] = '\0';
+    length = content_length;
+    return true;
+}
+
+template <typename T>
+void RadioLib_Wrapper<T>::add_checksum(String &msg)
+{
+    size_t crc_index_start = get_checksum_start(msg.c_str(), msg.length());
+    uint16_t crc = calculate_CRC16_CCITT_checksum(msg.c_str() + crc_index_start, msg.length() - crc_index_start);
+
+    char trailer[8];
+    uint8_t trailer_length = 0;
+    trailer[trailer_length++] = '*';
+    trailer_length += write_hex(trailer + trailer_length, crc);
+    trailer[trailer_length++] = '\n';
+    trailer[trailer_length] = '\0';
+    msg += trailer;
+}
+
+template <typename T>
+bool RadioLib_Wrapper<T>::check_checksum(String &msg)
+{
+    size_t content_start;
+    size_t content_length;
+    if (!verify_checksum(msg.c_str(), msg.length(), content_start, content_length, Checksum_Format::Hex))
     {
-        return false; // Checksum couldn't be verified
+        return false;
     }
+    // Remove the checksum from the original message in place
+    msg.remove(content_start + content_length);
+    msg.remove(0, content_start);
+    return true;
 }
 
 template <typename T>
@@ -0,0 +1,287 @@
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include "Radio_adaptive_rate.h"
+
+const Radio_Adaptive_Rate::Step Radio_Adaptive_Rate::DEFAULT_STEPS[] = {
+    {7, 125, 5, -7.5},
+    {8, 125, 5, -10},
+    {9, 125, 5, -12.5},
+    {10, 125, 5, -15},
+    {11, 125, 5, -17.5},
+    {12, 125, 5, -20},
+};
+const uint8_t Radio_Adaptive_Rate::DEFAULT_STEP_COUNT = sizeof(DEFAULT_STEPS) / sizeof(DEFAULT_STEPS[0]);
+
+Radio_Adaptive_Rate::Radio_Adaptive_Rate(const Config &config, uint8_t initial_step)
+{
+  _config = config;
+  memset(&_statistics, 0, sizeof(_statistics));
+  _step_index = initial_step < config.step_count ? initial_step : config.step_count - 1;
+  _applied_step_index = _step_index;
+  clear_samples();
+  _last_sample_time = millis();
+  _last_switch_time = _last_sample_time;
+  _remote_snr = 0;
+  _has_remote_snr = false;
+  _remote_snr_time = 0;
+  _report_time = _last_sample_time;
+  _request_active = false;
+  _requested_step = _step_index;
+  _change_id = 0;
+  _request_count = 0;
+  _request_time = 0;
+  _ack_pending = false;
+  _switch_after_ack = false;
+  _built_frame_type = 0;
+}
+
+void Radio_Adaptive_Rate::clear_samples()
+{
+  _sample_count = 0;
+  _sample_index = 0;
+}
+
+void Radio_Adaptive_Rate::add_sample(float snr, float rssi, uint32_t now)
+{
+  _snr_samples[_sample_index] = snr;
+  _rssi_samples[_sample_index] = rssi;
+  _sample_index = (_sample_index + 1) % RADIO_ADAPTIVE_RATE_WINDOW;
+  if (_sample_count < RADIO_ADAPTIVE_RATE_WINDOW)
+  {
+    _sample_count++;
+  }
+  _last_sample_time = now;
+}
+
+float Radio_Adaptive_Rate::get_average(const float *samples) const
+{
+  float sum = 0;
+  for (uint8_t i = 0; i < _sample_count; i++)
+  {
+    sum += samples[i];
+  }
+  return _sample_count > 0 ? sum / _sample_count : 0;
+}
+
+void Radio_Adaptive_Rate::switch_step(uint8_t step_index, uint32_t now)
+{
+  _step_index = step_index;
+  _last_switch_time = now;
+  // Old samples were measured with the previous step. Also give the new step time before falling back
+  clear_samples();
+  _last_sample_time = now;
+}
+
+bool Radio_Adaptive_Rate::choose_step(uint8_t &step_index, uint32_t now)
+{
+  // Both directions must have enough margin, so use the worse side if the responder reported its SNR recently.
+  // An old report would keep the link slow after the conditions improved
+  float snr = get_average_snr();
+  if (_has_remote_snr && now - _remote_snr_time < 2 * _config.hold_time && _remote_snr < snr)
+  {
+    snr = _remote_snr;
+  }
+
+  // Not enough margin, go to the fastest step that has it (or the most robust one)
+  if (snr - _config.steps[_step_index].required_snr < _config.link_margin)
+  {
+    step_index = _config.step_count - 1;
+    for (uint8_t i = _step_index + 1; i < _config.step_count; i++)
+    {
+      if (snr - _config.steps[i].required_snr >= _config.link_margin)
+      {
+        step_index = i;
+        break;
+      }
+    }
+    return step_index != _step_index;
+  }
+
+  // Plenty of margin, go one step faster
+  if (_step_index > 0 && snr - _config.steps[_step_index - 1].required_snr >= _config.link_margin + _config.hysteresis)
+  {
+    step_index = _step_index - 1;
+    return true;
+  }
+  return false;
+}
+
+uint16_t Radio_Adaptive_Rate::build_frame(uint8_t *frame, uint16_t frame_size, uint32_t now)
+{
+  _built_frame_type = 0;
+
+  // Link lost, both sides independently go to the most robust step
+  uint8_t most_robust_step = _config.step_count - 1;
+  if (now - _last_sample_time >= _config.fallback_timeout && _step_index != most_robust_step)
+  {
+    switch_step(most_robust_step, now);
+    _statistics.fallbacks++;
+    _request_active = false;
+    _switch_after_ack = false;
+    _has_remote_snr = false;
+  }
+
+  if (frame_size < RADIO_ADAPTIVE_RATE_MAX_FRAME_LENGTH)
+  {
+    return 0;
+  }
+
+  if (!_config.initiator)
+  {
+    if (_ack_pending)
+    {
+      return encode_snr_frame(frame, RADIO_ADAPTIVE_RATE_ACK);
+    }
+    // Keep the SNR of this direction fresh on the initiator, measured with the current step
+    if (!_switch_after_ack && _sample_count >= RADIO_ADAPTIVE_RATE_WINDOW && now - _report_time >= _config.hold_time)
+    {
+      return encode_snr_frame(frame, RADIO_ADAPTIVE_RATE_REPORT);
+    }
+    return 0;
+  }
+
+  if (_request_active)
+  {
+    if (_request_count != 0 && now - _request_time < _config.request_timeout)
+    {
+      return 0;
+    }
+    if (_request_count >= _config.max_requests)
+    {
+      // The responder most likely switched and only the ACK was lost
+      if (_requested_step < _step_index)
+      {
+        _statistics.faster_switches++;
+      }
+      else
+      {
+        _statistics.slower_switches++;
+      }
+      _statistics.unacknowledged++;
+      switch_step(_requested_step, now);
+      _request_active = false;
+      return 0;
+    }
+  }
+  else
+  {
+    uint8_t step_index;
+    if (now - _last_switch_time < _config.hold_time || _sample_count < RADIO_ADAPTIVE_RATE_WINDOW || !choose_step(step_index, now))
+    {
+      return 0;
+    }
+    _request_active = true;
+    _requested_step = step_index;
+    _change_id++;
+    _request_count = 0;
+  }
+
+  frame[0] = RADIO_ADAPTIVE_RATE_FRAME_MARKER | RADIO_ADAPTIVE_RATE_REQUEST;
+  frame[1] = _requested_step;
+  frame[2] = _change_id;
+  _built_frame_type = RADIO_ADAPTIVE_RATE_REQUEST;
+  return 3;
+}
+
+uint16_t Radio_Adaptive_Rate::encode_snr_frame(uint8_t *frame, uint8_t type)
+{
+  // SNR in 0.25 dB units, limited to the int8 range
+  float snr = get_average_snr() * 4;
+  snr = snr > 127 ? 127 : (snr < -128 ? -128 : snr);
+  frame[0] = RADIO_ADAPTIVE_RATE_FRAME_MARKER | type;
+  frame[1] = type == RADIO_ADAPTIVE_RATE_ACK ? _requested_step : _step_index;
+  frame[2] = _change_id;
+  frame[3] = static_cast<uint8_t>(static_cast<int8_t>(snr));
+  _built_frame_type = type;
+  return 4;
+}
+
+void Radio_Adaptive_Rate::mark_frame_sent(uint32_t now)
+{
+  if (_built_frame_type == RADIO_ADAPTIVE_RATE_REQUEST)
+  {
+    _request_count++;
+    _request_time = now;
+    _statistics.requests_sent++;
+  }
+  else if (_built_frame_type == RADIO_ADAPTIVE_RATE_REPORT)
+  {
+    _report_time = now;
+    _statistics.reports_sent++;
+  }
+  else if (_built_frame_type == RADIO_ADAPTIVE_RATE_ACK)
+  {
+    _ack_pending = false;
+    _report_time = now;
+    // The ACK went out with the old step, now follow the initiator
+    if (_switch_after_ack)
+    {
+      if (_requested_step < _step_index)
+      {
+        _statistics.faster_switches++;
+      }
+      else
+      {
+        _statistics.slower_switches++;
+      }
+      switch_step(_requested_step, now);
+      _switch_after_ack = false;
+    }
+  }
+  _built_frame_type = 0;
+}
+
+bool Radio_Adaptive_Rate::receive(const uint8_t *frame, uint16_t length, uint32_t now)
+{
+  if (length < 3 || (frame[0] & RADIO_ADAPTIVE_RATE_FRAME_MARKER_MASK) != RADIO_ADAPTIVE_RATE_FRAME_MARKER)
+  {
+    return false;
+  }
+
+  uint8_t type = frame[0] & ~RADIO_ADAPTIVE_RATE_FRAME_MARKER_MASK;
+  uint8_t step_index = frame[1];
+  uint8_t change_id = frame[2];
+  if (step_index >= _config.step_count)
+  {
+    return true;
+  }
+
+  if (type == RADIO_ADAPTIVE_RATE_REQUEST && !_config.initiator)
+  {
+    _requested_step = step_index;
+    _change_id = change_id;
+    _ack_pending = true;
+    _switch_after_ack = step_index != _step_index;
+  }
+  else if (type == RADIO_ADAPTIVE_RATE_ACK && _config.initiator && length >= 4)
+  {
+    if (_request_active && change_id == _change_id && step_index == _requested_step)
+    {
+      _remote_snr = static_cast<int8_t>(frame[3]) / 4.0;
+      _has_remote_snr = true;
+      _remote_snr_time = now;
+      if (_requested_step < _step_index)
+      {
+        _statistics.faster_switches++;
+      }
+      else
+      {
+        _statistics.slower_switches++;
+      }
+      switch_step(_requested_step, now);
+      _request_active = false;
+    }
+  }
+  else if (type == RADIO_ADAPTIVE_RATE_REPORT && _config.initiator && length >= 4)
+  {
+    // Reports sent before the last switch were measured with another step
+    if (!_request_active && step_index == _step_index && change_id == _change_id)
+    {
+      _remote_snr = static_cast<int8_t>(frame[3]) / 4.0;
+      _has_remote_snr = true;
+      _remote_snr_time = now;
+    }
+  }
+  return true;
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE
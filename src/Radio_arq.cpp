@@ -0,0 +1,427 @@
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include "Radio_arq.h"
+
+Radio_Arq::Radio_Arq(const Config &config, Receive_Function receive_function)
+{
+  _config = config;
+  _receive_function = receive_function;
+  reset();
+}
+
+void Radio_Arq::reset()
+{
+  for (Transmit_Slot &slot : _transmit_slots)
+  {
+    slot.length = 0;
+    slot.transmissions = 0;
+    slot.acknowledged = false;
+    slot.retransmit_now = false;
+  }
+  for (Receive_Slot &slot : _receive_slots)
+  {
+    slot.received = false;
+  }
+  _send_base = 0;
+  _send_next = 0;
+  _send_counter = 0;
+  _skip_pending = false;
+  _skip_transmissions = 0;
+  _skip_sent_time = 0;
+  _receive_base = 0;
+  _ack_pending = false;
+  _last_receive_time = 0;
+  _has_rtt_sample = false;
+  _smoothed_rtt = 0;
+  _rtt_variance = 0;
+  _retransmit_timeout = _config.initial_retransmit_timeout;
+  _built_frame = Frame_Kind::None;
+  memset(&_statistics, 0, sizeof(_statistics));
+}
+
+bool Radio_Arq::send(const uint8_t *data, uint16_t length)
+{
+  if (length > RADIO_ARQ_MAX_PAYLOAD_LENGTH || get_in_flight_count() >= RADIO_ARQ_WINDOW_SIZE)
+  {
+    return false;
+  }
+
+  Transmit_Slot &slot = get_transmit_slot(_send_next);
+  memcpy(slot.data, data, length);
+  slot.length = length;
+  slot.transmissions = 0;
+  slot.acknowledged = false;
+  slot.retransmit_now = false;
+  _send_next++;
+  return true;
+}
+
+uint32_t Radio_Arq::get_frame_timeout(const Transmit_Slot &slot) const
+{
+  // Exponential backoff, every retransmission doubles the timeout
+  uint32_t timeout = _retransmit_timeout;
+  for (uint8_t i = 1; i < slot.transmissions && timeout < _config.max_retransmit_timeout; i++)
+  {
+    timeout *= 2;
+  }
+  return timeout < _config.max_retransmit_timeout ? timeout : _config.max_retransmit_timeout;
+}
+
+bool Radio_Arq::find_frame_to_send(uint8_t &sequence, uint32_t now)
+{
+  // Retransmissions first, oldest frame first
+  for (uint8_t i = 0; i < get_in_flight_count(); i++)
+  {
+    uint8_t current = _send_base + i;
+    Transmit_Slot &slot = get_transmit_slot(current);
+    if (slot.acknowledged || slot.transmissions == 0)
+    {
+      continue;
+    }
+    if (!slot.retransmit_now && now - slot.sent_time < get_frame_timeout(slot))
+    {
+      continue;
+    }
+    if (slot.transmissions > _config.max_retransmissions)
+    {
+      // Give up, the new send base in the next frames tells the other side to skip it
+      slot.acknowledged = true;
+      _statistics.failed++;
+      _skip_pending = true;
+      _skip_transmissions = 0;
+      continue;
+    }
+    advance_send_base();
+    sequence = current;
+    return true;
+  }
+  advance_send_base();
+
+  // Then frames that were never sent
+  for (uint8_t i = 0; i < get_in_flight_count(); i++)
+  {
+    uint8_t current = _send_base + i;
+    if (get_transmit_slot(current).transmissions == 0)
+    {
+      sequence = current;
+      return true;
+    }
+  }
+  return false;
+}
+
+uint16_t Radio_Arq::build_frame(uint8_t *frame, uint16_t frame_size, uint32_t now)
+{
+  _built_frame = Frame_Kind::None;
+
+  uint8_t sequence;
+  if (find_frame_to_send(sequence, now))
+  {
+    Transmit_Slot &slot = get_transmit_slot(sequence);
+    uint16_t length = RADIO_ARQ_ACK_LENGTH + 1 + slot.length;
+    if (length > frame_size)
+    {
+      return 0;
+    }
+    // Data frames always carry the current ACK
+    encode_ack(frame);
+    frame[0] |= RADIO_ARQ_FLAG_DATA;
+    frame[RADIO_ARQ_ACK_LENGTH] = sequence;
+    memcpy(frame + RADIO_ARQ_ACK_LENGTH + 1, slot.data, slot.length);
+    _built_frame = Frame_Kind::Data;
+    _built_sequence = sequence;
+    return length;
+  }
+
+  // Repeat the skip notice like a data frame until the other side confirms it, also when there is nothing else to send
+  bool skip_due = _skip_pending && _skip_transmissions <= _config.max_retransmissions &&
+                  (_skip_transmissions == 0 || now - _skip_sent_time >= _retransmit_timeout);
+  if (((_ack_pending && now - _last_receive_time >= _config.ack_delay) || skip_due) && frame_size >= RADIO_ARQ_ACK_LENGTH)
+  {
+    _built_frame = Frame_Kind::Ack;
+    encode_ack(frame);
+    return RADIO_ARQ_ACK_LENGTH;
+  }
+  return 0;
+}
+
+void Radio_Arq::mark_frame_sent(uint32_t now)
+{
+  if (_built_frame == Frame_Kind::None)
+  {
+    return;
+  }
+
+  if (_built_frame == Frame_Kind::Data)
+  {
+    Transmit_Slot &slot = get_transmit_slot(_built_sequence);
+    if (slot.transmissions == 0)
+    {
+      _statistics.frames_sent++;
+    }
+    else
+    {
+      _statistics.retransmissions++;
+    }
+    slot.transmissions++;
+    slot.sent_time = now;
+    slot.send_order = ++_send_counter;
+    slot.retransmit_now = false;
+  }
+  else
+  {
+    _statistics.acks_sent++;
+  }
+  if (_skip_pending)
+  {
+    // Every frame carries the send base
+    _skip_sent_time = now;
+    if (_skip_transmissions < UINT8_MAX)
+    {
+      _skip_transmissions++;
+    }
+  }
+  _ack_pending = false;
+  _built_frame = Frame_Kind::None;
+}
+
+uint32_t Radio_Arq::get_ack_bitmap()
+{
+  // Bit 31 is the frame after the next expected one
+  uint32_t bitmap = 0;
+  for (uint8_t i = 1; i < RADIO_ARQ_WINDOW_SIZE; i++)
+  {
+    if (get_receive_slot(_receive_base + i).received)
+    {
+      bitmap |= static_cast<uint32_t>(1) << (32 - i);
+    }
+  }
+  return bitmap;
+}
+
+void Radio_Arq::encode_ack(uint8_t *buffer)
+{
+  uint32_t bitmap = get_ack_bitmap();
+  buffer[0] = RADIO_ARQ_FRAME_MARKER | RADIO_ARQ_FLAG_ACK | (_skip_pending ? RADIO_ARQ_FLAG_SKIP : 0);
+  buffer[1] = _send_base;
+  buffer[2] = _receive_base;
+  buffer[3] = (bitmap >> 24) & 0xFF;
+  buffer[4] = (bitmap >> 16) & 0xFF;
+  buffer[5] = (bitmap >> 8) & 0xFF;
+  buffer[6] = bitmap & 0xFF;
+}
+
+uint8_t Radio_Arq::write_ack(uint8_t *buffer)
+{
+  encode_ack(buffer);
+  _ack_pending = false;
+  return RADIO_ARQ_ACK_LENGTH;
+}
+
+bool Radio_Arq::receive(const uint8_t *frame, uint16_t length, uint32_t now)
+{
+  if (length < 1 || (frame[0] & RADIO_ARQ_FRAME_MARKER_MASK) != RADIO_ARQ_FRAME_MARKER)
+  {
+    return false;
+  }
+
+  uint8_t flags = frame[0];
+  uint16_t offset = 1;
+  if (flags & RADIO_ARQ_FLAG_ACK)
+  {
+    if (length < RADIO_ARQ_ACK_LENGTH)
+    {
+      return false;
+    }
+    uint32_t bitmap = (static_cast<uint32_t>(frame[3]) << 24) | (static_cast<uint32_t>(frame[4]) << 16) | (static_cast<uint32_t>(frame[5]) << 8) | frame[6];
+    process_send_base(frame[1], flags & RADIO_ARQ_FLAG_SKIP, now);
+    process_ack(frame[2], bitmap, now);
+    offset = RADIO_ARQ_ACK_LENGTH;
+  }
+  if (flags & RADIO_ARQ_FLAG_DATA)
+  {
+    if (length < offset + 1 || length - offset - 1 > RADIO_ARQ_MAX_PAYLOAD_LENGTH)
+    {
+      return false;
+    }
+    process_data(frame[offset], frame + offset + 1, length - offset - 1, now);
+  }
+  return true;
+}
+
+void Radio_Arq::process_ack(uint8_t next_expected, uint32_t bitmap, uint32_t now)
+{
+  uint8_t in_flight = get_in_flight_count();
+  uint32_t latest_send_order = 0;
+
+  for (uint8_t i = 0; i < in_flight; i++)
+  {
+    uint8_t sequence = _send_base + i;
+    Transmit_Slot &slot = get_transmit_slot(sequence);
+
+    // Acknowledged if before the next expected frame (only if that is inside the window, old ACKs are ignored) or set in the bitmap
+    uint8_t cumulative_offset = next_expected - _send_base;
+    uint8_t bitmap_offset = sequence - next_expected - 1;
+    bool acknowledged = (cumulative_offset <= in_flight && i < cumulative_offset) ||
+                        (bitmap_offset < 32 && ((bitmap >> (31 - bitmap_offset)) & 0x01));
+    if (!acknowledged || slot.transmissions == 0)
+    {
+      continue;
+    }
+
+    if (slot.send_order > latest_send_order)
+    {
+      latest_send_order = slot.send_order;
+    }
+    if (slot.acknowledged)
+    {
+      continue;
+    }
+    slot.acknowledged = true;
+    _statistics.acknowledged++;
+
+    // Karn's algorithm, retransmitted frames can't be matched to the right transmission
+    if (slot.transmissions == 1)
+    {
+      add_rtt_sample(now - slot.sent_time);
+    }
+  }
+
+  // The other side has skipped everything that was given up once it expects the send base or later
+  if (static_cast<uint8_t>(next_expected - _send_base) <= in_flight)
+  {
+    _skip_pending = false;
+  }
+
+  // Frames sent before an acknowledged frame, but not acknowledged themselves, were most likely lost
+  for (uint8_t i = 0; i < in_flight; i++)
+  {
+    Transmit_Slot &slot = get_transmit_slot(_send_base + i);
+    if (!slot.acknowledged && slot.transmissions != 0 && slot.send_order < latest_send_order)
+    {
+      slot.retransmit_now = true;
+    }
+  }
+
+  advance_send_base();
+}
+
+void Radio_Arq::advance_send_base()
+{
+  while (_send_base != _send_next && get_transmit_slot(_send_base).acknowledged)
+  {
+    get_transmit_slot(_send_base).acknowledged = false;
+    _send_base++;
+  }
+}
+
+void Radio_Arq::add_rtt_sample(uint32_t rtt)
+{
+  // Jacobson/Karels estimator with gains 1/8 and 1/4
+  if (!_has_rtt_sample)
+  {
+    _smoothed_rtt = rtt;
+    _rtt_variance = rtt / 2;
+    _has_rtt_sample = true;
+  }
+  else
+  {
+    uint32_t difference = rtt > _smoothed_rtt ? rtt - _smoothed_rtt : _smoothed_rtt - rtt;
+    _rtt_variance = (3 * _rtt_variance + difference) / 4;
+    _smoothed_rtt = (7 * _smoothed_rtt + rtt) / 8;
+  }
+
+  _retransmit_timeout = _smoothed_rtt + 4 * _rtt_variance;
+  if (_retransmit_timeout < _config.min_retransmit_timeout)
+  {
+    _retransmit_timeout = _config.min_retransmit_timeout;
+  }
+  if (_retransmit_timeout > _config.max_retransmit_timeout)
+  {
+    _retransmit_timeout = _config.max_retransmit_timeout;
+  }
+}
+
+void Radio_Arq::deliver_receive_base()
+{
+  Receive_Slot &slot = get_receive_slot(_receive_base);
+  if (slot.received)
+  {
+    if (_receive_function != nullptr)
+    {
+      _receive_function(slot.data, slot.length);
+    }
+    _statistics.delivered++;
+    slot.received = false;
+  }
+  else
+  {
+    _statistics.skipped++;
+  }
+  _receive_base++;
+}
+
+void Radio_Arq::process_send_base(uint8_t send_base, bool confirm, uint32_t now)
+{
+  // The other side only retransmits from its send base on, everything before it was received or given up.
+  // A send base behind the receive base just means our ACKs haven't arrived yet
+  uint8_t offset = send_base - _receive_base;
+  if (offset != 0 && offset < static_cast<uint8_t>(256 - RADIO_ARQ_WINDOW_SIZE))
+  {
+    while (_receive_base != send_base)
+    {
+      deliver_receive_base();
+    }
+    // Frames received after the gap are now in order
+    while (get_receive_slot(_receive_base).received)
+    {
+      deliver_receive_base();
+    }
+  }
+
+  if (confirm)
+  {
+    // Answer with the new receive base, so the other side stops repeating the notice
+    _ack_pending = true;
+    _last_receive_time = now;
+  }
+}
+
+void Radio_Arq::process_data(uint8_t sequence, const uint8_t *data, uint16_t length, uint32_t now)
+{
+  _ack_pending = true;
+  _last_receive_time = now;
+
+  uint8_t offset = sequence - _receive_base;
+  if (offset >= static_cast<uint8_t>(256 - RADIO_ARQ_WINDOW_SIZE))
+  {
+    // Already delivered, the ACK was lost
+    _statistics.duplicates++;
+    return;
+  }
+
+  // The other side can only be ahead of the window if it gave up some frames. The send base in the
+  // header has normally skipped them already
+  while (offset >= RADIO_ARQ_WINDOW_SIZE)
+  {
+    deliver_receive_base();
+    offset--;
+  }
+
+  Receive_Slot &slot = get_receive_slot(sequence);
+  if (slot.received)
+  {
+    _statistics.duplicates++;
+    return;
+  }
+  memcpy(slot.data, data, length);
+  slot.length = length;
+  slot.received = true;
+
+  // Deliver everything that is now in order
+  while (get_receive_slot(_receive_base).received)
+  {
+    deliver_receive_base();
+  }
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE
@@ -0,0 +1,100 @@
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include "Radio_duty_cycle.h"
+
+Radio_Duty_Cycle::Radio_Duty_Cycle(const Config &config, uint32_t now)
+{
+  _config = config;
+  memset(&_statistics, 0, sizeof(_statistics));
+
+  // Budget in microseconds, limited to the uint32_t range
+  double budget = static_cast<double>(config.window) * 1000 * config.duty_cycle;
+  _budget = budget >= UINT32_MAX ? UINT32_MAX : (budget < 0 ? 0 : budget + 0.5);
+
+  _bucket_width = config.window / RADIO_DUTY_CYCLE_BUCKETS;
+  if (_bucket_width == 0)
+  {
+    _bucket_width = 1;
+  }
+  memset(_buckets, 0, sizeof(_buckets));
+  _newest_bucket = 0;
+  _bucket_end = now + _bucket_width;
+}
+
+void Radio_Duty_Cycle::advance(uint32_t now)
+{
+  // Signed difference, so millis() overflow is handled
+  if (static_cast<int32_t>(now - _bucket_end) < 0)
+  {
+    return;
+  }
+
+  uint32_t steps = (now - _bucket_end) / _bucket_width + 1;
+  if (steps > RADIO_DUTY_CYCLE_BUCKETS)
+  {
+    // Everything has expired
+    memset(_buckets, 0, sizeof(_buckets));
+    _bucket_end = now + _bucket_width;
+    return;
+  }
+  for (uint32_t i = 0; i < steps; i++)
+  {
+    _newest_bucket = (_newest_bucket + 1) % (RADIO_DUTY_CYCLE_BUCKETS + 1);
+    _buckets[_newest_bucket] = 0;
+  }
+  _bucket_end += steps * _bucket_width;
+}
+
+uint32_t Radio_Duty_Cycle::get_used_time_on_air(uint32_t now)
+{
+  advance(now);
+  uint32_t used = 0;
+  for (uint32_t time_on_air : _buckets)
+  {
+    used += time_on_air;
+  }
+  return used;
+}
+
+bool Radio_Duty_Cycle::can_transmit(uint32_t time_on_air, uint32_t now)
+{
+  uint32_t used = get_used_time_on_air(now);
+  return used <= _budget && time_on_air <= _budget - used;
+}
+
+bool Radio_Duty_Cycle::get_next_transmit_time(uint32_t time_on_air, uint32_t &time, uint32_t now)
+{
+  if (time_on_air > _budget)
+  {
+    return false;
+  }
+  uint32_t used = get_used_time_on_air(now);
+  if (used <= _budget && time_on_air <= _budget - used)
+  {
+    time = now;
+    return true;
+  }
+
+  // Buckets expire oldest first, the oldest one at the end of the current bucket
+  uint32_t needed = used - (_budget - time_on_air);
+  uint32_t freed = 0;
+  for (uint8_t i = 0; i <= RADIO_DUTY_CYCLE_BUCKETS; i++)
+  {
+    freed += _buckets[(_newest_bucket + 1 + i) % (RADIO_DUTY_CYCLE_BUCKETS + 1)];
+    if (freed >= needed)
+    {
+      time = _bucket_end + i * _bucket_width;
+      return true;
+    }
+  }
+  // Not reached, all buckets together free the whole used time
+  time = _bucket_end + RADIO_DUTY_CYCLE_BUCKETS * _bucket_width;
+  return true;
+}
+
+void Radio_Duty_Cycle::add_transmission(uint32_t time_on_air, uint32_t now)
+{
+  advance(now);
+  _buckets[_newest_bucket] += time_on_air;
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE
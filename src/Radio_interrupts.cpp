@@ -0,0 +1,60 @@
+#if defined(RADIOLIB_WRAPPER_ENABLE) || defined(RANGING_WRAPPER_ENABLE)
+#include "Radio_interrupts.h"
+
+namespace RadioLib_interrupts
+{
+    static Action_Flag *volatile attached_flags[RADIO_INTERRUPTS_MAX_RADIOS] = {};
+
+    /*
+    If compiling for ESP boards, specify that these function are used within interrupt routine
+    and such should be stored in the RAM and not the flash memory
+    */
+    template <uint8_t Slot>
+#if defined(ESP8266) || defined(ESP32)
+    ICACHE_RAM_ATTR
+#endif
+    void set_action_done_flag(void)
+    {
+        Action_Flag *flag = attached_flags[Slot];
+        if (flag != nullptr)
+        {
+            flag->done = true;
+            flag->time = millis();
+        }
+    }
+
+    static void (*const INTERRUPT_FUNCTIONS[4])(void) = {
+        set_action_done_flag<0>,
+        set_action_done_flag<1>,
+        set_action_done_flag<2>,
+        set_action_done_flag<3>,
+    };
+
+    int8_t attach(Action_Flag *flag)
+    {
+        for (int8_t slot = 0; slot < RADIO_INTERRUPTS_MAX_RADIOS; slot++)
+        {
+            if (attached_flags[slot] == nullptr)
+            {
+                attached_flags[slot] = flag;
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    void detach(int8_t slot)
+    {
+        if (slot >= 0 && slot < RADIO_INTERRUPTS_MAX_RADIOS)
+        {
+            attached_flags[slot] = nullptr;
+        }
+    }
+
+    void (*get_interrupt_function(int8_t slot))(void)
+    {
+        return INTERRUPT_FUNCTIONS[slot];
+    }
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE || RANGING_WRAPPER_ENABLE
@@ -0,0 +1,247 @@
+#ifdef RADIOLIB_WRAPPER_ENABLE
+#include "Radio_tdma.h"
+
+// Largest difference between the measured and nominal superframe length accepted from a beacon
+const float RADIO_TDMA_MAX_CLOCK_ERROR = 0.001;
+// The superframe length is measured between beacons at least this many superframes apart, so the
+// millisecond timestamps and the interrupt latency barely affect it
+const uint32_t RADIO_TDMA_MIN_BASELINE = 16;
+// Start a new measurement after this many superframes, so slow changes like temperature drift are followed
+const uint32_t RADIO_TDMA_MAX_BASELINE = 1024;
+
+// Round microseconds up to milliseconds
+static uint32_t to_milliseconds(uint32_t time_on_air)
+{
+  return (time_on_air + 999) / 1000;
+}
+
+Radio_Tdma::Radio_Tdma(const Config &config, uint32_t now)
+{
+  _config = config;
+  memset(&_statistics, 0, sizeof(_statistics));
+
+  // Every slot has room for starting the transmission late by up to the timing margin
+  _guard_time = get_guard_time(config);
+  _beacon_slot_length = to_milliseconds(config.beacon_time_on_air) + 2 * _guard_time + config.timing_margin;
+  _slot_length = to_milliseconds(config.max_time_on_air) + 2 * _guard_time + config.timing_margin;
+  _superframe_length = _beacon_slot_length + config.slot_count * _slot_length;
+
+  _local_superframe_length = _superframe_length;
+  _reference_counter = 0;
+  _baseline_time = now;
+  _baseline_superframes = 0;
+  _beacon_sent = false;
+  _built_beacon = false;
+
+  // The master defines the time, the other nodes wait for a beacon
+  _synchronized = config.node_id == RADIO_TDMA_MASTER_NODE;
+  _reference_time = now;
+}
+
+uint32_t Radio_Tdma::get_guard_time(const Config &config)
+{
+  // Both clocks can be off by the tolerance. The error builds up until the next received beacon, at most
+  // max_missed_beacons + 2 superframes after the last one. The guard time itself makes the superframe longer:
+  //   guard = margin + rate x ((slots + 1) x (margin + 2 x guard) + beacon + slots x frame)
+  float rate = 2 * config.clock_tolerance / 1000000 * (config.max_missed_beacons + 2);
+  float fixed_length = (config.slot_count + 1) * config.timing_margin + to_milliseconds(config.beacon_time_on_air) + config.slot_count * to_milliseconds(config.max_time_on_air);
+  float divisor = 1 - 2 * rate * (config.slot_count + 1);
+  if (divisor <= 0)
+  {
+    // Clocks too inaccurate to ever stay in sync, use the longest guard that keeps the numbers sane
+    return UINT16_MAX;
+  }
+  return ceil((config.timing_margin + rate * fixed_length) / divisor);
+}
+
+bool Radio_Tdma::get_superframe(uint32_t now, uint32_t &start, uint8_t &counter, float &scale)
+{
+  if (!_synchronized)
+  {
+    return false;
+  }
+
+  if (_config.node_id == RADIO_TDMA_MASTER_NODE)
+  {
+    // Move the reference along, so the master keeps exact integer superframes
+    while (now - _reference_time >= _superframe_length && static_cast<int32_t>(now - _reference_time) >= 0)
+    {
+      _reference_time += _superframe_length;
+      _reference_counter++;
+      _beacon_sent = false;
+    }
+    start = _reference_time;
+    counter = _reference_counter;
+    scale = 1;
+    return true;
+  }
+
+  // Superframes since the last beacon, negative if now is before the reference
+  int32_t elapsed = now - _reference_time;
+  int32_t superframes = floor(elapsed / _local_superframe_length);
+  if (superframes > _config.max_missed_beacons + 1)
+  {
+    _synchronized = false;
+    _statistics.sync_losses++;
+    return false;
+  }
+  start = _reference_time + static_cast<int32_t>(round(superframes * _local_superframe_length));
+  counter = _reference_counter + superframes;
+  scale = _local_superframe_length / _superframe_length;
+  return true;
+}
+
+uint16_t Radio_Tdma::build_beacon(uint8_t *frame, uint16_t frame_size, uint32_t now)
+{
+  _built_beacon = false;
+  uint32_t start;
+  uint8_t counter;
+  float scale;
+  if (_config.node_id != RADIO_TDMA_MASTER_NODE || frame_size < RADIO_TDMA_BEACON_LENGTH || !get_superframe(now, start, counter, scale) || _beacon_sent)
+  {
+    return 0;
+  }
+
+  // The beacon is scheduled after the guard time of the beacon slot
+  uint32_t elapsed = now - start;
+  if (elapsed < _guard_time)
+  {
+    return 0;
+  }
+  uint32_t delay = elapsed - _guard_time;
+  if (delay > _config.timing_margin)
+  {
+    // It would overlap the first data slot
+    _beacon_sent = true;
+    _statistics.beacons_skipped++;
+    return 0;
+  }
+
+  frame[0] = RADIO_TDMA_FRAME_MARKER | RADIO_TDMA_BEACON;
+  frame[1] = counter;
+  frame[2] = delay > UINT8_MAX ? UINT8_MAX : delay;
+  _built_beacon = true;
+  return RADIO_TDMA_BEACON_LENGTH;
+}
+
+void Radio_Tdma::mark_beacon_sent()
+{
+  if (!_built_beacon)
+  {
+    return;
+  }
+  _built_beacon = false;
+  _beacon_sent = true;
+  _statistics.beacons_sent++;
+}
+
+bool Radio_Tdma::receive(const uint8_t *frame, uint16_t length, uint32_t arrival_time)
+{
+  if (length < RADIO_TDMA_BEACON_LENGTH || (frame[0] & RADIO_TDMA_FRAME_MARKER_MASK) != RADIO_TDMA_FRAME_MARKER ||
+      (frame[0] & ~RADIO_TDMA_FRAME_MARKER_MASK) != RADIO_TDMA_BEACON)
+  {
+    return false;
+  }
+  if (_config.node_id == RADIO_TDMA_MASTER_NODE)
+  {
+    return true;
+  }
+
+  // Start of the superframe in the local clock: the beacon started one time on air before the interrupt,
+  // the delay and guard time after the superframe start
+  uint8_t counter = frame[1];
+  float offset = _config.beacon_time_on_air / 1000.0 + frame[2] + _guard_time;
+  uint32_t start = arrival_time - static_cast<uint32_t>(round(offset));
+
+  // Measure the superframe length of the master with the local clock
+  if (_synchronized)
+  {
+    _baseline_superframes += static_cast<uint8_t>(counter - _reference_counter);
+    if (_baseline_superframes >= RADIO_TDMA_MIN_BASELINE)
+    {
+      float measured = static_cast<int32_t>(start - _baseline_time) / static_cast<float>(_baseline_superframes);
+      if (fabs(measured - _superframe_length) <= _superframe_length * RADIO_TDMA_MAX_CLOCK_ERROR)
+      {
+        _local_superframe_length = measured;
+      }
+    }
+  }
+  if (!_synchronized || _baseline_superframes >= RADIO_TDMA_MAX_BASELINE)
+  {
+    _baseline_time = start;
+    _baseline_superframes = 0;
+  }
+
+  _reference_time = start;
+  _reference_counter = counter;
+  _synchronized = true;
+  _statistics.beacons_received++;
+  return true;
+}
+
+bool Radio_Tdma::can_transmit(uint32_t time_on_air, uint32_t now)
+{
+  uint32_t start;
+  uint8_t counter;
+  float scale;
+  if (!get_superframe(now, start, counter, scale))
+  {
+    return false;
+  }
+
+  // Position in the superframe in the master clock
+  float position = static_cast<int32_t>(now - start) / scale;
+  if (position < _beacon_slot_length)
+  {
+    return false;
+  }
+  uint32_t slot = (position - _beacon_slot_length) / _slot_length;
+  if (slot >= _config.slot_count || _config.slot_owners[slot] != _config.node_id)
+  {
+    return false;
+  }
+  float slot_position = position - _beacon_slot_length - slot * _slot_length;
+  return slot_position >= _guard_time && slot_position + time_on_air / 1000.0 <= _slot_length - _guard_time;
+}
+
+bool Radio_Tdma::get_next_transmit_time(uint32_t time_on_air, uint32_t &time, uint32_t now)
+{
+  uint32_t start;
+  uint8_t counter;
+  float scale;
+  if (time_on_air / 1000.0 > _slot_length - 2 * _guard_time || !get_superframe(now, start, counter, scale))
+  {
+    return false;
+  }
+  if (can_transmit(time_on_air, now))
+  {
+    time = now;
+    return true;
+  }
+
+  // First owned slot that starts its transmit window after now, in this or the next superframe
+  float position = static_cast<int32_t>(now - start) / scale;
+  for (uint8_t superframe = 0; superframe < 2; superframe++)
+  {
+    for (uint8_t slot = 0; slot < _config.slot_count; slot++)
+    {
+      float slot_start = superframe * _superframe_length + _beacon_slot_length + slot * _slot_length + _guard_time;
+      if (_config.slot_owners[slot] == _config.node_id && slot_start > position)
+      {
+        time = start + static_cast<uint32_t>(ceil(slot_start * scale));
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool Radio_Tdma::is_synchronized(uint32_t now)
+{
+  uint32_t start;
+  uint8_t counter;
+  float scale;
+  return get_superframe(now, start, counter, scale);
+}
+
+#endif // RADIOLIB_WRAPPER_ENABLE
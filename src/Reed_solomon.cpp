@@ -0,0 +1,190 @@
+#ifdef CCSDS_PACKETS_ENABLE
+#include "Reed_solomon.h"
+
+namespace Galois_Field
+{
+  // Constant initialized, so the tables are stored in flash and don't need any setup
+  const Tables TABLES = Tables();
+}
+
+using namespace Galois_Field;
+
+Reed_Solomon::Reed_Solomon(uint8_t parity_symbols)
+{
+  if (parity_symbols > REED_SOLOMON_MAX_PARITY_SYMBOLS)
+  {
+    parity_symbols = REED_SOLOMON_MAX_PARITY_SYMBOLS;
+  }
+  _parity_symbols = parity_symbols & ~0x01; // Must be even
+
+  // Generator polynomial g(x) = (x + alpha^1)(x + alpha^2)...(x + alpha^parity_symbols)
+  memset(_generator, 0, sizeof(_generator));
+  _generator[0] = 1;
+  for (uint8_t root = 1; root <= _parity_symbols; root++)
+  {
+    uint8_t alpha = power_of_alpha(root);
+    for (uint8_t i = root; i > 0; i--)
+    {
+      _generator[i] = _generator[i - 1] ^ multiply(alpha, _generator[i]);
+    }
+    _generator[0] = multiply(alpha, _generator[0]);
+  }
+}
+
+void Reed_Solomon::encode(const uint8_t *data, uint8_t data_length, uint8_t *parity) const
+{
+  // Remainder of data(x) * x^parity_symbols divided by g(x), highest degree first
+  memset(parity, 0, _parity_symbols);
+  for (uint8_t i = 0; i < data_length; i++)
+  {
+    uint8_t feedback = data[i] ^ parity[0];
+    for (uint8_t j = 0; j + 1 < _parity_symbols; j++)
+    {
+      parity[j] = parity[j + 1] ^ multiply(feedback, _generator[_parity_symbols - 1 - j]);
+    }
+    parity[_parity_symbols - 1] = multiply(feedback, _generator[0]);
+  }
+}
+
+int16_t Reed_Solomon::decode(uint8_t *codeword, uint8_t length) const
+{
+  if (length <= _parity_symbols)
+  {
+    return -1;
+  }
+
+  // Syndromes S_i = codeword(alpha^(i + 1))
+  uint8_t syndromes[REED_SOLOMON_MAX_PARITY_SYMBOLS];
+  bool has_errors = false;
+  for (uint8_t i = 0; i < _parity_symbols; i++)
+  {
+    uint8_t alpha = power_of_alpha(i + 1);
+    uint8_t syndrome = 0;
+    for (uint8_t j = 0; j < length; j++)
+    {
+      syndrome = multiply(syndrome, alpha) ^ codeword[j];
+    }
+    syndromes[i] = syndrome;
+    has_errors |= syndrome != 0;
+  }
+  if (!has_errors)
+  {
+    return 0;
+  }
+
+  // Berlekamp-Massey, finds the error locator polynomial lambda(x)
+  uint8_t lambda[REED_SOLOMON_MAX_PARITY_SYMBOLS + 1] = {1};
+  uint8_t previous[REED_SOLOMON_MAX_PARITY_SYMBOLS + 1] = {1};
+  uint8_t temporary[REED_SOLOMON_MAX_PARITY_SYMBOLS + 1];
+  uint8_t error_count = 0;
+  uint8_t shift = 1;
+  uint8_t previous_discrepancy = 1;
+  for (uint8_t r = 0; r < _parity_symbols; r++)
+  {
+    uint8_t discrepancy = syndromes[r];
+    for (uint8_t i = 1; i <= error_count; i++)
+    {
+      discrepancy ^= multiply(lambda[i], syndromes[r - i]);
+    }
+
+    if (discrepancy == 0)
+    {
+      shift++;
+      continue;
+    }
+
+    uint8_t scale = divide(discrepancy, previous_discrepancy);
+    memcpy(temporary, lambda, sizeof(lambda));
+    for (uint8_t i = 0; i + shift <= _parity_symbols; i++)
+    {
+      lambda[i + shift] ^= multiply(scale, previous[i]);
+    }
+
+    if (2 * error_count <= r)
+    {
+      error_count = r + 1 - error_count;
+      memcpy(previous, temporary, sizeof(previous));
+      previous_discrepancy = discrepancy;
+      shift = 1;
+    }
+    else
+    {
+      shift++;
+    }
+  }
+  if (error_count > _parity_symbols / 2)
+  {
+    return -1;
+  }
+
+  // Error evaluator omega(x) = S(x) * lambda(x) mod x^parity_symbols
+  uint8_t omega[REED_SOLOMON_MAX_PARITY_SYMBOLS];
+  for (uint8_t i = 0; i < _parity_symbols; i++)
+  {
+    omega[i] = 0;
+    for (uint8_t j = 0; j <= i && j <= error_count; j++)
+    {
+      omega[i] ^= multiply(syndromes[i - j], lambda[j]);
+    }
+  }
+
+  // Chien search for the error positions and Forney algorithm for the error values
+  // Symbol at index j has degree length - 1 - j, so its locator is alpha^(length - 1 - j)
+  uint8_t error_positions[REED_SOLOMON_MAX_PARITY_SYMBOLS / 2];
+  uint8_t error_values[REED_SOLOMON_MAX_PARITY_SYMBOLS / 2];
+  uint8_t found = 0;
+  for (uint8_t j = 0; j < length; j++)
+  {
+    uint16_t degree = length - 1 - j;
+    uint8_t locator_inverse = power_of_alpha(255 - degree);
+
+    // lambda(X^-1) and its formal derivative (only odd powers remain in GF(2^8))
+    uint8_t lambda_value = 0;
+    uint8_t derivative_value = 0;
+    uint8_t x_power = 1;
+    for (uint8_t i = 0; i <= error_count; i++)
+    {
+      uint8_t term = multiply(lambda[i], x_power);
+      lambda_value ^= term;
+      if (i & 0x01)
+      {
+        derivative_value ^= multiply(lambda[i], divide(x_power, locator_inverse));
+      }
+      x_power = multiply(x_power, locator_inverse);
+    }
+    if (lambda_value != 0)
+    {
+      continue;
+    }
+    if (derivative_value == 0 || found >= error_count)
+    {
+      return -1;
+    }
+
+    uint8_t omega_value = 0;
+    x_power = 1;
+    for (uint8_t i = 0; i < _parity_symbols; i++)
+    {
+      omega_value ^= multiply(omega[i], x_power);
+      x_power = multiply(x_power, locator_inverse);
+    }
+
+    error_positions[found] = j;
+    error_values[found] = divide(omega_value, derivative_value);
+    found++;
+  }
+
+  // Every root must be inside the (shortened) codeword, otherwise the errors can't be corrected
+  if (found != error_count)
+  {
+    return -1;
+  }
+
+  for (uint8_t i = 0; i < found; i++)
+  {
+    codeword[error_positions[i]] ^= error_values[i];
+  }
+  return found;
+}
+
+#endif // CCSDS_PACKETS_ENABLE
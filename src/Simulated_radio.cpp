@@ -0,0 +1,520 @@
+#ifdef SIMULATED_RADIO_ENABLE
+#include "Simulated_radio.h"
+
+// Perfect channel with the real time on air
+const Simulated_Air::Config Simulated_Air::DEFAULT_CONFIG = {0, 0, 0, -60, 10, 0, 1, true, 1};
+
+Simulated_Air::Simulated_Air(const Config &config)
+{
+  memset(_radios, 0, sizeof(_radios));
+  memset(_frames, 0, sizeof(_frames));
+  set_config(config);
+}
+
+Simulated_Air &Simulated_Air::get_default()
+{
+  static Simulated_Air air;
+  return air;
+}
+
+void Simulated_Air::set_config(const Config &config)
+{
+  _config = config;
+  memset(&_statistics, 0, sizeof(_statistics));
+  _random_state = config.seed != 0 ? config.seed : 1;
+}
+
+uint32_t Simulated_Air::next_random()
+{
+  // xorshift32, same sequence on every platform
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 17;
+  _random_state ^= _random_state << 5;
+  return _random_state;
+}
+
+float Simulated_Air::next_random_float()
+{
+  return (next_random() >> 8) / static_cast<float>(1UL << 24);
+}
+
+bool Simulated_Air::attach(Simulated_Radio *radio)
+{
+  for (uint8_t i = 0; i < SIMULATED_AIR_MAX_RADIOS; i++)
+  {
+    if (_radios[i] == nullptr)
+    {
+      _radios[i] = radio;
+      radio->_index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void Simulated_Air::detach(Simulated_Radio *radio)
+{
+  stop_listening(radio);
+  for (Frame &frame : _frames)
+  {
+    if (frame.used && frame.sender == radio->_index && !frame.aborted)
+    {
+      frame.aborted = true;
+    }
+  }
+  _radios[radio->_index] = nullptr;
+}
+
+bool Simulated_Air::is_same_channel(const Frame &frame, const Simulated_Radio &radio) const
+{
+  // The carrier is off from the set frequency by the configured frequency error
+  double carrier = frame.frequency + _config.frequency_error / 1000000.0;
+  return fabs(carrier - radio._frequency) * 1000 < frame.signal_bw / 2 && frame.signal_bw == radio._signal_bw &&
+         frame.spreading == radio._spreading && frame.sync_word == radio._sync_word;
+}
+
+void Simulated_Air::stop_listening(Simulated_Radio *radio)
+{
+  for (Frame &frame : _frames)
+  {
+    frame.listeners &= ~(1UL << radio->_index);
+  }
+}
+
+void Simulated_Air::abort_transmit(Simulated_Radio *radio, uint32_t now)
+{
+  for (Frame &frame : _frames)
+  {
+    if (frame.used && frame.sender == radio->_index && !frame.aborted && static_cast<int32_t>(now - frame.end) < 0)
+    {
+      // The channel is free again from now
+      frame.aborted = true;
+      frame.end = now;
+      _statistics.aborted++;
+    }
+  }
+}
+
+void Simulated_Air::start_transmit(Simulated_Radio *radio, const uint8_t *data, uint16_t length, uint32_t time_on_air, uint32_t now)
+{
+  _statistics.frames_sent++;
+
+  Frame *free_frame = nullptr;
+  for (Frame &frame : _frames)
+  {
+    if (!frame.used)
+    {
+      free_frame = &frame;
+      break;
+    }
+  }
+  if (free_frame == nullptr)
+  {
+    _statistics.overflows++;
+    return;
+  }
+
+  Frame &frame = *free_frame;
+  frame.used = true;
+  memcpy(frame.data, data, length);
+  frame.length = length;
+  frame.sender = radio->_index;
+  frame.start = now;
+  frame.end = now + time_on_air;
+  frame.delivery_time = frame.end + _config.latency;
+  frame.collided = false;
+  frame.aborted = false;
+  frame.frequency = radio->_frequency;
+  frame.signal_bw = radio->_signal_bw;
+  frame.spreading = radio->_spreading;
+  frame.sync_word = radio->_sync_word;
+
+  // Radios that are already listening on the channel can receive it
+  frame.listeners = 0;
+  for (uint8_t i = 0; i < SIMULATED_AIR_MAX_RADIOS; i++)
+  {
+    if (_radios[i] != nullptr && i != frame.sender && _radios[i]->_state == Simulated_Radio::State::Receive && is_same_channel(frame, *_radios[i]))
+    {
+      frame.listeners |= 1UL << i;
+    }
+  }
+
+  // Frames on the same channel that are still in the air collide with this one
+  for (Frame &other : _frames)
+  {
+    if (&other == &frame || !other.used || static_cast<int32_t>(now - other.end) >= 0)
+    {
+      continue;
+    }
+    if (fabs(other.frequency - frame.frequency) * 1000 < frame.signal_bw / 2 && other.spreading == frame.spreading && other.signal_bw == frame.signal_bw)
+    {
+      other.collided = true;
+      frame.collided = true;
+    }
+  }
+}
+
+void Simulated_Air::deliver(Frame &frame)
+{
+  frame.used = false;
+  if (frame.aborted)
+  {
+    return;
+  }
+
+  for (uint8_t i = 0; i < SIMULATED_AIR_MAX_RADIOS; i++)
+  {
+    Simulated_Radio *radio = _radios[i];
+    // Must have been receiving for the whole frame and still be receiving
+    if (radio == nullptr || !(frame.listeners & (1UL << i)) || radio->_state != Simulated_Radio::State::Receive)
+    {
+      continue;
+    }
+    if (frame.collided)
+    {
+      _statistics.collisions++;
+      continue;
+    }
+    if (next_random_float() < _config.loss)
+    {
+      _statistics.frames_lost++;
+      continue;
+    }
+
+    // Continuous receive, the radio keeps receiving and the next frame overwrites this one
+    memcpy(radio->_rx_data, frame.data, frame.length);
+    radio->_rx_length = frame.length;
+    radio->_rx_corrupted = false;
+    if (_config.bit_error_rate > 0)
+    {
+      for (uint16_t bit = 0; bit < frame.length * 8; bit++)
+      {
+        if (next_random_float() < _config.bit_error_rate)
+        {
+          radio->_rx_data[bit / 8] ^= 0x80 >> (bit % 8);
+          radio->_rx_corrupted = true;
+        }
+      }
+    }
+    if (radio->_rx_corrupted)
+    {
+      _statistics.frames_corrupted++;
+    }
+    radio->_rx_rssi = _config.rssi;
+    radio->_rx_snr = _config.snr;
+    // Same sign as RadioLib and Frequency_Tracker: positive if the carrier is below the receiver frequency
+    radio->_rx_frequency_error = (radio->_frequency - frame.frequency) * 1000000.0 - _config.frequency_error;
+    _statistics.frames_delivered++;
+
+    if (radio->_action != nullptr)
+    {
+      radio->_action();
+    }
+  }
+}
+
+void Simulated_Air::update(uint32_t now)
+{
+  // Handle the events in time order, so interrupts happen in the same order as with real radios
+  while (true)
+  {
+    Simulated_Radio *next_radio = nullptr;
+    for (Simulated_Radio *radio : _radios)
+    {
+      if (radio != nullptr && radio->_state == Simulated_Radio::State::Transmit && static_cast<int32_t>(now - radio->_transmit_end) >= 0 &&
+          (next_radio == nullptr || static_cast<int32_t>(radio->_transmit_end - next_radio->_transmit_end) < 0))
+      {
+        next_radio = radio;
+      }
+    }
+    Frame *next_frame = nullptr;
+    for (Frame &frame : _frames)
+    {
+      if (frame.used && static_cast<int32_t>(now - frame.delivery_time) >= 0 &&
+          (next_frame == nullptr || static_cast<int32_t>(frame.delivery_time - next_frame->delivery_time) < 0))
+      {
+        next_frame = &frame;
+      }
+    }
+
+    if (next_radio != nullptr && (next_frame == nullptr || static_cast<int32_t>(next_radio->_transmit_end - next_frame->delivery_time) <= 0))
+    {
+      // Transmit done interrupt, the radio goes to standby like a real one
+      next_radio->_state = Simulated_Radio::State::Standby;
+      if (next_radio->_action != nullptr)
+      {
+        next_radio->_action();
+      }
+    }
+    else if (next_frame != nullptr)
+    {
+      deliver(*next_frame);
+    }
+    else
+    {
+      return;
+    }
+  }
+}
+
+Simulated_Radio::Simulated_Radio(Module * /* module */)
+{
+  _air = nullptr;
+  _index = 0;
+  _state = State::Standby;
+  _transmit_end = 0;
+  _action = nullptr;
+  _family = Radio_Time_On_Air::Chip_Family::Sx126x;
+  _frequency = 434;
+  _signal_bw = 125;
+  _spreading = 9;
+  _coding_rate = 7;
+  _sync_word = 0x12;
+  _tx_power = 10;
+  _rx_length = 0;
+  _rx_corrupted = false;
+  _rx_rssi = 0;
+  _rx_snr = 0;
+  _rx_frequency_error = 0;
+}
+
+Simulated_Radio::Simulated_Radio(const Simulated_Radio &other) : Simulated_Radio()
+{
+  *this = other;
+}
+
+Simulated_Radio &Simulated_Radio::operator=(const Simulated_Radio &other)
+{
+  if (this == &other)
+  {
+    return *this;
+  }
+  if (_air != nullptr)
+  {
+    _air->detach(this);
+    _air = nullptr;
+  }
+  _state = State::Standby;
+  _action = other._action;
+  _family = other._family;
+  _frequency = other._frequency;
+  _signal_bw = other._signal_bw;
+  _spreading = other._spreading;
+  _coding_rate = other._coding_rate;
+  _sync_word = other._sync_word;
+  _tx_power = other._tx_power;
+  _rx_length = 0;
+  return *this;
+}
+
+Simulated_Radio::~Simulated_Radio()
+{
+  if (_air != nullptr)
+  {
+    _air->detach(this);
+  }
+}
+
+bool Simulated_Radio::set_air(Simulated_Air &air)
+{
+  if (_air != nullptr)
+  {
+    _air->detach(this);
+    _air = nullptr;
+  }
+  _state = State::Standby;
+  if (!air.attach(this))
+  {
+    return false;
+  }
+  _air = &air;
+  return true;
+}
+
+void Simulated_Radio::set_state(State state)
+{
+  if (_air != nullptr)
+  {
+    if (_state == State::Transmit)
+    {
+      _air->abort_transmit(this, micros());
+    }
+    _air->stop_listening(this);
+  }
+  _state = state;
+}
+
+int16_t Simulated_Radio::begin(float freq, float bw, uint8_t sf, uint8_t cr, uint8_t syncWord, int8_t power)
+{
+  if (_air == nullptr && !set_air(Simulated_Air::get_default()))
+  {
+    return RADIOLIB_ERR_CHIP_NOT_FOUND;
+  }
+  set_state(State::Standby);
+  _frequency = freq;
+  _signal_bw = bw;
+  _spreading = sf;
+  _coding_rate = cr;
+  _sync_word = syncWord;
+  _tx_power = power;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setFrequency(float freq)
+{
+  if (freq <= 0)
+  {
+    return RADIOLIB_ERR_INVALID_FREQUENCY;
+  }
+  set_state(State::Standby);
+  _frequency = freq;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setBandwidth(float bw)
+{
+  if (bw <= 0)
+  {
+    return RADIOLIB_ERR_INVALID_BANDWIDTH;
+  }
+  set_state(State::Standby);
+  _signal_bw = bw;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setSpreadingFactor(uint8_t sf)
+{
+  if (sf < 5 || sf > 12)
+  {
+    return RADIOLIB_ERR_INVALID_SPREADING_FACTOR;
+  }
+  set_state(State::Standby);
+  _spreading = sf;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setCodingRate(uint8_t cr)
+{
+  if (cr < 5 || cr > 8)
+  {
+    return RADIOLIB_ERR_INVALID_CODING_RATE;
+  }
+  set_state(State::Standby);
+  _coding_rate = cr;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setSyncWord(uint8_t syncWord)
+{
+  set_state(State::Standby);
+  _sync_word = syncWord;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::setOutputPower(int8_t power)
+{
+  _tx_power = power;
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::standby()
+{
+  set_state(State::Standby);
+  return RADIOLIB_ERR_NONE;
+}
+
+uint32_t Simulated_Radio::getTimeOnAir(size_t len)
+{
+  return Radio_Time_On_Air::get_time_on_air(_family, _spreading, _signal_bw, _coding_rate, len);
+}
+
+int16_t Simulated_Radio::startTransmit(uint8_t *data, size_t len, uint8_t /* addr */)
+{
+  if (len > SIMULATED_RADIO_MAX_FRAME_LENGTH)
+  {
+    return RADIOLIB_ERR_PACKET_TOO_LONG;
+  }
+  if (_air == nullptr)
+  {
+    return RADIOLIB_ERR_CHIP_NOT_FOUND;
+  }
+  set_state(State::Transmit);
+  uint32_t now = micros();
+  uint32_t time_on_air = getTimeOnAir(len) * _air->get_config().time_on_air_scale;
+  _transmit_end = now + time_on_air;
+  _air->start_transmit(this, data, len, time_on_air, now);
+  _air->update(now);
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::startTransmit(String &str, uint8_t addr)
+{
+  return startTransmit((uint8_t *)str.c_str(), str.length(), addr);
+}
+
+int16_t Simulated_Radio::finishTransmit()
+{
+  return standby();
+}
+
+int16_t Simulated_Radio::transmit(uint8_t *data, size_t len, uint8_t addr)
+{
+  int16_t state = startTransmit(data, len, addr);
+  if (state != RADIOLIB_ERR_NONE)
+  {
+    return state;
+  }
+  // Blocks like RadioLib, the time must advance in delay()
+  while (_state == State::Transmit)
+  {
+    delay(1);
+    _air->update();
+  }
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::transmit(String &str, uint8_t addr)
+{
+  return transmit((uint8_t *)str.c_str(), str.length(), addr);
+}
+
+int16_t Simulated_Radio::startReceive()
+{
+  if (_air == nullptr)
+  {
+    return RADIOLIB_ERR_CHIP_NOT_FOUND;
+  }
+  set_state(State::Receive);
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::readData(uint8_t *data, size_t len)
+{
+  if (len == 0 || len > _rx_length)
+  {
+    len = _rx_length;
+  }
+  memcpy(data, _rx_data, len);
+  if (_rx_corrupted && _air != nullptr && _air->get_config().crc)
+  {
+    return RADIOLIB_ERR_CRC_MISMATCH;
+  }
+  return RADIOLIB_ERR_NONE;
+}
+
+int16_t Simulated_Radio::readData(String &str, size_t len)
+{
+  char buffer[SIMULATED_RADIO_MAX_FRAME_LENGTH + 1];
+  int16_t state = readData(reinterpret_cast<uint8_t *>(buffer), len);
+  size_t length = len == 0 || len > _rx_length ? _rx_length : len;
+  buffer[length] = '\0';
+  str = String(buffer);
+  return state;
+}
+
+size_t Simulated_Radio::getPacketLength(bool /* update */)
+{
+  return _rx_length;
+}
+
+#endif // SIMULATED_RADIO_ENABLE
@@ -3,11 +3,6 @@
 #include "ranging_wrapper.h"
 #include <math.h>
 
-volatile bool sx1280_lora_ranging = false; // can't be moved inside class. Shows if lora is actively doing ranging
-void sx1280_ranging_end(void)
-{
-    sx1280_lora_ranging = false;
-}
 Ranging_Wrapper::Position Ranging_Wrapper::Position_Local::to_geodetic()
 {
     Position result;
@@ -77,13 +72,32 @@ String Ranging_Wrapper::begin_lora(Mode mode, Lora_Device config)
 
     return status;
 }
+Ranging_Wrapper::~Ranging_Wrapper()
+{
+    // Stop the interrupt from writing to this wrapper's flag before it is gone
+    RadioLib_interrupts::detach(_interrupt_slot);
+    delete _lora.getMod();
+}
+
 String Ranging_Wrapper::init(Mode mode, Lora_Device config)
 {
     _lora_initialized = false;
+    // The radio doesn't own its module, free the previous one
+    delete _lora.getMod();
     _lora = new Module(config.CS, config.DIO1, config.RESET, config.DIO0, *config.SPI);
     _mode = mode;
     _config = config;
 
+    // Each ranging wrapper has its own interrupt function and flag, so other radios can be used at the same time
+    if (_interrupt_slot < 0)
+    {
+        _interrupt_slot = RadioLib_interrupts::attach(&_ranging_flag);
+    }
+    if (_interrupt_slot < 0)
+    {
+        return " SX1280 error (no free interrupt slot)";
+    }
+
     return begin_lora(mode, config);
 }
 // will return result from previous slave and start ranging on current slave
@@ -94,18 +108,18 @@ bool Ranging_Wrapper::master_read(Ranging_Slave slave, Ranging_Result &result, l
     {
         return slave_done;
     }
-    if (sx1280_lora_ranging)
+    if (is_ranging())
     {
         // check if should timeout
         if (millis() >= _ranging_start_time + timeout)
         {
-            sx1280_lora_ranging = false;
+            _ranging_flag.done = true;
             _lora_range_state = RADIOLIB_ERR_RANGING_TIMEOUT;
             _lora.clearDio1Action();
             _lora.finishTransmit();
         }
     }
-    if (!sx1280_lora_ranging)
+    if (!is_ranging())
     {
 
         // if available read result
@@ -135,8 +149,8 @@ bool Ranging_Wrapper::master_read(Ranging_Slave slave, Ranging_Result &result, l
         begin_lora(_mode, _config);
 
         // setup interrupt
-        _lora.setDio1Action(sx1280_ranging_end);
-        sx1280_lora_ranging = true;
+        _lora.setDio1Action(RadioLib_interrupts::get_interrupt_function(_interrupt_slot));
+        _ranging_flag.done = false;
         _lora_range_state = _lora.startRanging(true, slave.address);
         _ranging_start_time = millis();
         if (_lora_range_state != RADIOLIB_ERR_NONE)
@@ -153,19 +167,19 @@ bool Ranging_Wrapper::slave_reenable(long int timeout, Ranging_Slave slave)
         return false;
     }
     bool result = false;
-    if (sx1280_lora_ranging)
+    if (is_ranging())
     {
         // check if should timeout
         if (millis() >= _ranging_start_time + timeout)
         {
-            sx1280_lora_ranging = false;
+            _ranging_flag.done = true;
             _lora_range_state = RADIOLIB_ERR_RANGING_TIMEOUT;
             _lora.clearDio1Action();
             _lora.finishTransmit();
         }
         result = false;
     }
-    if (!sx1280_lora_ranging)
+    if (!is_ranging())
     {
 
         // if available read result
@@ -183,8 +197,8 @@ bool Ranging_Wrapper::slave_reenable(long int timeout, Ranging_Slave slave)
         begin_lora(_mode, _config);
 
         // setup interrupt
-        _lora.setDio1Action(sx1280_ranging_end);
-        sx1280_lora_ranging = true;
+        _lora.setDio1Action(RadioLib_interrupts::get_interrupt_function(_interrupt_slot));
+        _ranging_flag.done = false;
         _lora_range_state = _lora.startRanging(false, slave.address);
         _ranging_start_time = millis();
         if (_lora_range_state != RADIOLIB_ERR_NONE)